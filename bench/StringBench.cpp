@@ -0,0 +1,247 @@
+// Benchmarks for string/ algorithms on generated corpora.
+// Usage: string_bench [max_size = 1000000] [corpus ...]
+// Sizes go from 1e3 to max_size by powers of ten. For every algorithm it prints throughput,
+// peak resident memory during the run and number of heap allocations per run.
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../string/Aho.cpp"
+#include "../string/EnhancedSuffixArray.cpp"
+#include "../string/PackedSequence.h"
+#include "../string/PrefFunc.cpp"
+#include "../string/SuffArray + LCP.cpp"
+#include "../string/ZFunc.cpp"
+
+namespace {
+    std::atomic<uint64_t> allocations{0};
+}
+
+// Allocations are counted by replacing the global operators. They are kept out of line, otherwise after inlining
+// GCC sees std::free of memory from operator new (-Wmismatched-new-delete). Other forms forward to these two.
+[[gnu::noinline]] void* operator new(size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* result = std::malloc(size == 0 ? 1 : size)) return result;
+    throw std::bad_alloc();
+}
+void* operator new[](size_t size) { return operator new(size); }
+[[gnu::noinline]] void operator delete(void* pointer) noexcept { std::free(pointer); }
+void operator delete[](void* pointer) noexcept { operator delete(pointer); }
+void operator delete(void* pointer, size_t) noexcept { operator delete(pointer); }
+void operator delete[](void* pointer, size_t) noexcept { operator delete(pointer); }
+
+namespace Corpus {
+    // All corpora avoid '\0', which is used as the suffix array sentinel.
+    std::string Random(size_t size, std::mt19937& rng) {
+        std::string result(size, ' ');
+        for (auto& symbol : result) symbol = char(33 + rng() % 94);
+        return result;
+    }
+
+    std::string Dna(size_t size, std::mt19937& rng) {
+        std::string result(size, ' ');
+        for (auto& symbol : result) symbol = "ACGT"[rng() % 4];
+        return result;
+    }
+
+    // Words of a small vocabulary with Zipf-like frequencies separated by spaces
+    std::string English(size_t size, std::mt19937& rng) {
+        static const std::vector<std::string> words = {
+                "the", "of", "and", "to", "in", "is", "was", "that", "for", "it", "with", "as", "on", "be",
+                "at", "by", "this", "had", "not", "are", "but", "from", "or", "have", "an", "they", "which",
+                "one", "you", "were", "all", "her", "she", "there", "would", "their", "we", "him", "been",
+                "has", "when", "who", "will", "more", "no", "if", "out", "so", "said", "what", "up", "its",
+                "about", "into", "than", "them", "can", "only", "other", "new", "some", "could", "time"};
+        std::vector<double> weights;
+        for (size_t i = 0; i < words.size(); ++i) weights.push_back(1.0 / (i + 1));
+        std::discrete_distribution<size_t> word(weights.begin(), weights.end());
+        std::string result;
+        result.reserve(size + 16);
+        while (result.size() < size) {
+            result += words[word(rng)];
+            result += rng() % 12 == 0 ? ". " : " ";
+        }
+        result.resize(size);
+        return result;
+    }
+
+    // Fibonacci word: maximal number of repeats, worst case for many suffix sorting algorithms
+    std::string Fibonacci(size_t size, std::mt19937&) {
+        std::string previous = "a", current = "ab";
+        while (current.size() < size) {
+            std::string next = current + previous;
+            previous = std::move(current);
+            current = std::move(next);
+        }
+        current.resize(size);
+        return current;
+    }
+
+    std::string ThueMorse(size_t size, std::mt19937&) {
+        std::string result(size, 'a');
+        for (size_t i = 0; i < size; ++i) {
+            if (__builtin_popcountll(i) % 2 == 1) result[i] = 'b';
+        }
+        return result;
+    }
+
+    std::string Same(size_t size, std::mt19937&) {
+        return std::string(size, 'a');
+    }
+
+    const std::vector<std::pair<std::string, std::function<std::string(size_t, std::mt19937&)>>> ALL = {
+            {"random", Random}, {"dna", Dna}, {"english", English},
+            {"fibonacci", Fibonacci}, {"thue-morse", ThueMorse}, {"same", Same}};
+}
+
+namespace Memory {
+    // Resets peak resident set size of the process (Linux 4.0+), returns false if it is not allowed
+    bool ResetPeak() {
+        std::ofstream clear_refs("/proc/self/clear_refs");
+        clear_refs << "5";
+        return static_cast<bool>(clear_refs.flush());
+    }
+
+    // Peak resident set size in kilobytes
+    size_t Peak() {
+        std::ifstream status("/proc/self/status");
+        std::string line;
+        while (std::getline(status, line)) {
+            if (line.rfind("VmHWM:", 0) == 0) return std::stoull(line.substr(6));
+        }
+        return 0;
+    }
+}
+
+struct Measurement {
+    double   megabytes_per_second;
+    size_t   peak_kilobytes;
+    uint64_t allocations_per_run;
+};
+
+// Repeats the run until it takes at least 0.2 seconds in total. The first run is a warm-up which is not
+// timed, it may allocate state kept by the run between calls.
+Measurement Measure(size_t size, const std::function<size_t()>& run) {
+    Memory::ResetPeak();
+    volatile size_t sink = run();
+    size_t runs = 0;
+    uint64_t allocations_before = allocations.load();
+    auto start = std::chrono::steady_clock::now();
+    double seconds = 0;
+    do {
+        sink = sink + run();
+        runs++;
+        seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    } while (seconds < 0.2);
+    uint64_t allocations_total = allocations.load() - allocations_before;
+    return {double(size) * runs / seconds / 1e6, Memory::Peak(), allocations_total / runs};
+}
+
+// Run which builds a suffix array on its first call and rebuilds it on the next ones. Rebuilds reuse memory
+// of the array and of the workspace, they should not allocate. Both are owned by the run, so they are
+// counted only in its own peak memory.
+std::function<size_t()> Rebuilds(const std::string& terminated, SuffixArrayAlgorithm algorithm) {
+    auto workspace = std::make_shared<SuffixArrayWorkspace<>>();
+    std::shared_ptr<SuffixArray<std::string>> rebuilt;
+    return [&terminated, algorithm, workspace, rebuilt]() mutable {
+        if (rebuilt == nullptr) {
+            rebuilt = std::make_shared<SuffixArray<std::string>>(terminated, 256, algorithm, 1, workspace.get());
+        } else {
+            rebuilt->Rebuild(terminated);
+        }
+        return rebuilt->GetArrayView().size();
+    };
+}
+
+int main(int argc, char** argv) {
+    size_t max_size = argc > 1 ? std::stoull(argv[1]) : 1000000;
+    std::vector<std::string> corpora;
+    for (int i = 2; i < argc; ++i) corpora.emplace_back(argv[i]);
+
+    if (!Memory::ResetPeak()) std::printf("# peak RSS can't be reset, it is reported for the whole process\n");
+    std::printf("%-12s %-22s %12s %12s %14s %14s\n", "corpus", "algorithm", "size", "MB/s", "peak RSS, KB",
+                "allocs/run");
+
+    std::mt19937 rng(2021);
+    for (const auto& corpus : Corpus::ALL) {
+        if (!corpora.empty() && std::find(corpora.begin(), corpora.end(), corpus.first) == corpora.end()) continue;
+        for (size_t size = 1000; size <= max_size; size *= 10) {
+            std::string text = corpus.second(size, rng);
+            std::string terminated = text + '\0';
+            // Wildcard pattern taken from the middle of the text, so that it occurs at least once
+            std::string pattern = text.substr(size / 2, 8);
+            pattern[pattern.size() / 2] = '?';
+
+            std::vector<std::pair<std::string, std::function<size_t()>>> algorithms = {
+                    {"SuffixArray", [&] {
+                        return SuffixArray<std::string>(terminated).GetArrayView().size();
+                    }},
+                    {"SuffixArray SA-IS", [&] {
+                        return SuffixArray<std::string>(terminated, 256, SuffixArrayAlgorithm::InducedSorting)
+                                .GetArrayView().size();
+                    }},
+                    {"SuffixArray::Rebuild", Rebuilds(terminated, SuffixArrayAlgorithm::PrefixDoubling)},
+                    {"SA-IS Rebuild", Rebuilds(terminated, SuffixArrayAlgorithm::InducedSorting)},
+                    {"SuffixArray+BuildLCP", [&] {
+                        SuffixArray<std::string> suffix_array(terminated, 256, SuffixArrayAlgorithm::InducedSorting);
+                        suffix_array.BuildLCP();
+                        return suffix_array.GetLCPView().size();
+                    }},
+                    {"SuffixArray+Phi LCP", [&] {
+                        SuffixArray<std::string> suffix_array(terminated, 256, SuffixArrayAlgorithm::InducedSorting);
+                        suffix_array.BuildLCP(LCPAlgorithm::Phi);
+                        return suffix_array.GetLCPView().size();
+                    }},
+                    {"BuildLCP compressed", [&] {
+                        SuffixArray<std::string> suffix_array(terminated, 256, SuffixArrayAlgorithm::InducedSorting);
+                        suffix_array.BuildLCP(LCPAlgorithm::Kasai, LCPStorage::Compressed);
+                        return suffix_array.GetCompressedLCP().size();
+                    }},
+                    {"EnhancedSuffixArray", [&] {
+                        SuffixArray<std::string> suffix_array(terminated, 256, SuffixArrayAlgorithm::InducedSorting);
+                        return EnhancedSuffixArray<std::string>(suffix_array).MaximalRepeats().size();
+                    }},
+                    {"TTrie::find", [&] {
+                        return TTrie(pattern).find(text).size();
+                    }},
+                    {"CalculateZFunc", [&] {
+                        return CalculateZFunc(text.begin(), text.end()).size();
+                    }},
+                    {"CalculatePrefixFunc", [&] {
+                        return CalculatePrefixFunc(text.begin(), text.end()).size();
+                    }},
+            };
+            if (corpus.first == "dna") {
+                // 2 bits per base, word-at-a-time LCP and k-mer keys in the first sort
+                algorithms.emplace_back("Packed SuffixArray", [&] {
+                    return SuffixArray<PackedSequence<>>(PackedSequence<>(text), PackedSequence<>::ALPHABET_SIZE)
+                            .GetArrayView().size();
+                });
+                algorithms.emplace_back("Packed SA-IS+BuildLCP", [&] {
+                    SuffixArray<PackedSequence<>> suffix_array(PackedSequence<>(text), PackedSequence<>::ALPHABET_SIZE,
+                                                               SuffixArrayAlgorithm::InducedSorting);
+                    suffix_array.BuildLCP();
+                    return suffix_array.GetLCPView().size();
+                });
+            }
+            for (auto& algorithm : algorithms) {
+                Measurement result = Measure(size, algorithm.second);
+                algorithm.second = nullptr; // releases the state of the run before the next one
+                std::printf("%-12s %-22s %12zu %12.1f %14zu %14llu\n", corpus.first.c_str(), algorithm.first.c_str(),
+                            size, result.megabytes_per_second, result.peak_kilobytes,
+                            static_cast<unsigned long long>(result.allocations_per_run));
+                std::fflush(stdout);
+            }
+        }
+    }
+    return 0;
+}
@@ -1,34 +1,76 @@
+#include <algorithm>
+#include <array>
+#include <cstring>
 #include <iostream>
+#include <stdexcept>
 #include <vector>
 #include <string>
+#include <string_view>
+#include <thread>
 
-const size_t ALPHABET_SIZE = 26;
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+// Разбиение байтов на классы: каждый байт, встречающийся в шаблонах, образует свой класс,
+// все остальные байты попадают в класс 0. Таблица переходов автомата хранит по столбцу
+// на класс, поэтому она узкая, пока шаблоны используют немного разных байтов.
+struct TByteClasses {
+    std::array<int, 256> class_of;
+    size_t               size;
+
+    TByteClasses() : class_of{}, size(1) {}
+
+    void add(char byte) {
+        if (class_of[static_cast<unsigned char>(byte)] == 0) {
+            class_of[static_cast<unsigned char>(byte)] = size++;
+        }
+    }
+    int operator()(char byte) const { return class_of[static_cast<unsigned char>(byte)]; }
+};
 
 struct TTrie {
 public:
     std::vector<int> find(const std::string& text);
-    explicit TTrie(const std::string& pattern) : current_state(0), pattern(pattern),
+    // Потоковый поиск: текст подаётся кусками, состояние автомата переносится между вызовами.
+    // callback(offset) получает смещение начала вхождения от начала потока, вхождения могут
+    // начинаться в предыдущих кусках. После того как автомат достроится, память не выделяется.
+    template <typename Callback>
+    void feed(const char* data, size_t size, Callback callback);
+    template <typename Callback>
+    void feed(std::string_view chunk, Callback callback) { feed(chunk.data(), chunk.size(), callback); }
+    // Начинает новый поток, построенные вершины автомата сохраняются.
+    void reset() {
+        current_state = 0;
+        processed = 0;
+    }
+
+    explicit TTrie(const std::string& pattern) : current_state(0), processed(0), pattern(pattern),
                                                  pattern_size(pattern.size()) {
+        for (char symbol : pattern) {
+            if (symbol != '?') classes.add(symbol);
+        }
         state.emplace_back(-1, -1, 0); // Инициализация корня
+        next.assign(classes.size, -1);
     }
 
 private:
     struct TVertex {
-        std::vector<int> next;
         int              parent;
         size_t           depth;
         int              income_symbol;
         int              link;
 
-        TVertex() : next(ALPHABET_SIZE, -1), parent(-1), depth(-1), income_symbol(-1), link(-1) {}
-
         explicit TVertex(int parent = -1, int income_symbol = -1, int depth = -1,
-                         int link = -1) : next(ALPHABET_SIZE, -1), parent(parent),
-                                          depth(depth), income_symbol(income_symbol), link(link) {}
+                         int link = -1) : parent(parent), depth(depth), income_symbol(income_symbol), link(link) {}
     };
 
     int                  current_state;
+    uint64_t             processed; // сколько символов потока уже обработано
     std::vector<TVertex> state;
+    // Переходы всех вершин в одном массиве: next[v * classes.size + c] - переход из v по классу c.
+    std::vector<int>     next;
+    TByteClasses         classes;
     const std::string&   pattern;
     size_t               pattern_size;
 
@@ -43,14 +85,48 @@ private:
 // Возвращаемое значение - индексы начала вхождения шаблона.
 std::vector<int> TTrie::find(const std::string& text) {
     std::vector<int> result;
+    uint64_t start = processed;
+    feed(text.data(), text.size(), [&result, start](uint64_t offset) {
+        result.push_back(offset - start);
+    });
+    return result;
+}
 
-    for (size_t i = 0; i < text.size(); ++i) {
-        current_state = go(current_state, text[i] - 'a');
+
+template <typename Callback>
+void TTrie::feed(const char* data, size_t size, Callback callback) {
+    for (size_t i = 0; i < size; ++i) {
+        current_state = go(current_state, classes(data[i]));
         if (state[current_state].depth == pattern_size) {
-            result.push_back(i - pattern_size + 1);
+            callback(processed + i + 1 - pattern_size);
         }
     }
+    processed += size;
+}
+
+
+// Параллельный поиск шаблона с '?'. Текст делится на threads кусков, каждый поток ищет своим
+// автоматом, начиная за pattern_size - 1 символов до своего куска, и оставляет только вхождения,
+// которые кончаются в его куске. Поэтому вхождения не теряются и не повторяются, а склеенный
+// по порядку потоков результат совпадает с TTrie(pattern).find(text).
+std::vector<uint64_t> parallel_find(const std::string& pattern, const std::string& text, size_t threads) {
+    threads = std::max<size_t>(threads, 1);
+    std::vector<std::vector<uint64_t>> found(threads);
+    auto search = [&](size_t chunk) {
+        size_t begin = text.size() * chunk / threads, end = text.size() * (chunk + 1) / threads;
+        size_t overlap = std::min(begin, pattern.size() > 0 ? pattern.size() - 1 : 0);
+        TTrie trie(pattern);
+        trie.feed(text.data() + begin - overlap, end - begin + overlap, [&](uint64_t offset) {
+            if (offset + pattern.size() > overlap) found[chunk].push_back(begin - overlap + offset);
+        });
+    };
+    std::vector<std::thread> workers;
+    for (size_t chunk = 1; chunk < threads; ++chunk) workers.emplace_back(search, chunk);
+    search(0);
+    for (auto& worker : workers) worker.join();
 
+    std::vector<uint64_t> result;
+    for (const auto& part : found) result.insert(result.end(), part.begin(), part.end());
     return result;
 }
 
@@ -67,19 +143,428 @@ int TTrie::get_link(int state_ind) {
 
 
 int TTrie::go(int state_ind, int symbol) {
-    if (state[state_ind].next[symbol] != -1) {
-        return state[state_ind].next[symbol];
+    int& transition = next[state_ind * classes.size + symbol];
+    if (transition != -1) {
+        return transition;
     }
     // Создаем вершину в автомате, есть совпадение с шаблоном.
     // Так мы получим не все возможные варианты строк (каждый '?' - любой символ),
     // а только те, которые действительно встречаются в тексте.
     if (state[state_ind].depth != pattern_size &&
-        (pattern[state[state_ind].depth] - 'a' == symbol || pattern[state[state_ind].depth] == '?')) {
+        (pattern[state[state_ind].depth] == '?' || classes(pattern[state[state_ind].depth]) == symbol)) {
         state.emplace_back(state_ind, symbol, state[state_ind].depth + 1);
-        return state[state_ind].next[symbol] = state.size() - 1;
+        next.resize(next.size() + classes.size, -1); // ссылка transition после этого недействительна
+        return next[state_ind * classes.size + symbol] = state.size() - 1;
     }
     if (state_ind == 0) {
-        return state[state_ind].next[symbol] = 0;
+        return transition = 0;
+    }
+    int result = go(get_link(state_ind), symbol);
+    return next[state_ind * classes.size + symbol] = result;
+}
+
+
+// Поиск шаблона с '?' методом Shift-And. Бит j маски символа c выставлен, если pattern[j] == c
+// или pattern[j] == '?'. Состояние D = ((D << 1) | 1) & mask[c], бит j в D означает, что
+// pattern[0..j] совпадает с концом прочитанного текста. Шаблоны от 1 до 64 символов, без ветвлений в цикле,
+// для других длин конструктор бросает std::invalid_argument.
+struct TShiftAnd {
+public:
+    explicit TShiftAnd(const std::string& pattern) : masks{}, pattern_size(pattern.size()) {
+        if (pattern_size == 0 || pattern_size > 64) {
+            throw std::invalid_argument("TShiftAnd: pattern length should be in [1, 64]");
+        }
+        for (size_t j = 0; j < pattern_size; ++j) {
+            for (size_t c = 0; c < masks.size(); ++c) {
+                if (pattern[j] == '?' || static_cast<unsigned char>(pattern[j]) == c) masks[c] |= uint64_t(1) << j;
+            }
+        }
+    }
+
+    // callback(position) для каждого вхождения, позиции считаются от data.
+    template <typename Callback>
+    void find(const char* data, size_t size, Callback callback) const {
+        const uint64_t hit = uint64_t(1) << (pattern_size - 1);
+        uint64_t current = 0;
+        for (size_t i = 0; i < size; ++i) {
+            current = ((current << 1) | 1) & masks[static_cast<unsigned char>(data[i])];
+            if (current & hit) callback(i + 1 - pattern_size);
+        }
+    }
+
+    std::vector<uint64_t> find(const std::string& text) const {
+        std::vector<uint64_t> result;
+        find(text.data(), text.size(), [&result](uint64_t position) { result.push_back(position); });
+        return result;
+    }
+
+private:
+    std::array<uint64_t, 256> masks;
+    size_t                    pattern_size;
+};
+
+
+// Shift-And для длинных шаблонов: состояние из нескольких 64-битных слов, сдвиг идёт с переносом
+// между словами. Если собрано с AVX2, шаблоны до 256 символов обрабатываются одним ymm-регистром.
+// Пустой шаблон не допускается.
+struct TWideShiftAnd {
+public:
+    explicit TWideShiftAnd(const std::string& pattern) : pattern_size(pattern.size()),
+                                                         words((pattern.size() + 63) / 64) {
+        if (pattern_size == 0) throw std::invalid_argument("TWideShiftAnd: pattern should not be empty");
+#ifdef __AVX2__
+        if (words <= 4) words = 4;
+#endif
+        masks.assign(256 * words, 0);
+        for (size_t j = 0; j < pattern_size; ++j) {
+            for (size_t c = 0; c < 256; ++c) {
+                if (pattern[j] == '?' || static_cast<unsigned char>(pattern[j]) == c) {
+                    masks[c * words + j / 64] |= uint64_t(1) << (j % 64);
+                }
+            }
+        }
+    }
+
+    std::vector<uint64_t> find(const std::string& text) const;
+
+private:
+    size_t                pattern_size;
+    size_t                words;
+    std::vector<uint64_t> masks; // masks[c * words + w] - слово w маски символа c
+};
+
+
+std::vector<uint64_t> TWideShiftAnd::find(const std::string& text) const {
+    std::vector<uint64_t> result;
+    const size_t last_word = (pattern_size - 1) / 64, last_bit = (pattern_size - 1) % 64;
+#ifdef __AVX2__
+    if (words == 4) {
+        const __m256i one = _mm256_set_epi64x(0, 0, 0, 1);
+        uint64_t hit_words[4] = {};
+        hit_words[last_word] = uint64_t(1) << last_bit;
+        const __m256i hit = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(hit_words));
+        __m256i current = _mm256_setzero_si256();
+        for (size_t i = 0; i < text.size(); ++i) {
+            // Старший бит каждого слова переносится в младший бит следующего, в первое слово вдвигается 1.
+            __m256i carry = _mm256_permute4x64_epi64(_mm256_srli_epi64(current, 63), _MM_SHUFFLE(2, 1, 0, 3));
+            carry = _mm256_blend_epi32(carry, one, 0x03);
+            const auto* mask = reinterpret_cast<const __m256i*>(&masks[static_cast<unsigned char>(text[i]) * 4]);
+            current = _mm256_and_si256(_mm256_or_si256(_mm256_slli_epi64(current, 1), carry), _mm256_loadu_si256(mask));
+            if (!_mm256_testz_si256(current, hit)) result.push_back(i + 1 - pattern_size);
+        }
+        return result;
+    }
+#endif
+    std::vector<uint64_t> current(words, 0);
+    for (size_t i = 0; i < text.size(); ++i) {
+        const uint64_t* mask = &masks[static_cast<unsigned char>(text[i]) * words];
+        uint64_t carry = 1;
+        for (size_t w = 0; w < words; ++w) {
+            uint64_t next_carry = current[w] >> 63;
+            current[w] = ((current[w] << 1) | carry) & mask[w];
+            carry = next_carry;
+        }
+        if ((current[last_word] >> last_bit) & 1) result.push_back(i + 1 - pattern_size);
+    }
+    return result;
+}
+
+
+// Поиск шаблона с '?' подходящим движком: Shift-And в одно слово для шаблонов до 64 символов,
+// многословный Shift-And до 512 символов, для более длинных - автомат TTrie.
+std::vector<uint64_t> wildcard_find(const std::string& pattern, const std::string& text) {
+    if (pattern.empty() || pattern.size() > 512) {
+        TTrie trie(pattern);
+        std::vector<uint64_t> result;
+        trie.feed(text.data(), text.size(), [&result](uint64_t offset) { result.push_back(offset); });
+        return result;
+    }
+    if (pattern.size() <= 64) return TShiftAnd(pattern).find(text);
+    return TWideShiftAnd(pattern).find(text);
+}
+
+
+// Поиск шаблона с '?' для текстов, где вхождений мало. Из шаблона выбирается самый редкий
+// отрезок без '?' и в нём два самых редких байта (по частотам обычного текста). Кандидаты ищутся
+// сравнением этих двух байтов сразу для 32 позиций (AVX2) или через memchr, и только кандидаты
+// проверяются целиком.
+struct TPrefilteredSearch {
+public:
+    explicit TPrefilteredSearch(const std::string& pattern);
+
+    // callback(position) для каждого вхождения по возрастанию позиций, позиции считаются от data.
+    template <typename Callback>
+    void find(const char* data, size_t size, Callback callback) const;
+    std::vector<uint64_t> find(const std::string& text) const {
+        std::vector<uint64_t> result;
+        find(text.data(), text.size(), [&result](uint64_t position) { result.push_back(position); });
+        return result;
+    }
+
+private:
+    // Чем больше значение, тем чаще байт встречается в текстах: пробел, строчные буквы по частоте
+    // в английском, цифры, заглавные буквы, пунктуация; управляющие и не-ASCII байты самые редкие.
+    static int frequency(unsigned char byte);
+    bool matches(const char* window) const;
+
+    std::string        pattern;
+    bool               has_literal;
+    size_t             first_offset;  // позиции двух байтов-якорей в шаблоне
+    size_t             second_offset;
+};
+
+
+int TPrefilteredSearch::frequency(unsigned char byte) {
+    static const std::string letters = "etaoinshrdlcumwfgypbvkjxqz";
+    if (byte == ' ') return 100;
+    if (byte >= 'a' && byte <= 'z') return 99 - letters.find(byte);
+    if (byte >= '0' && byte <= '9') return 60;
+    if (byte >= 'A' && byte <= 'Z') return 50;
+    if (byte == '\n' || (byte > ' ' && byte < 0x7f)) return 40;
+    return 0;
+}
+
+
+TPrefilteredSearch::TPrefilteredSearch(const std::string& pattern) : pattern(pattern), has_literal(false),
+                                                                     first_offset(0), second_offset(0) {
+    // Лучший отрезок - с самым редким байтом, из равных - самый длинный.
+    size_t best_begin = 0, best_end = 0;
+    int best_rarity = 0;
+    for (size_t begin = 0, end; begin < pattern.size(); begin = end + 1) {
+        end = pattern.find('?', begin);
+        if (end == std::string::npos) end = pattern.size();
+        if (begin == end) continue;
+        int rarity = 0;
+        for (size_t j = begin; j < end; ++j) rarity = std::max(rarity, 100 - frequency(pattern[j]));
+        if (rarity > best_rarity || (rarity == best_rarity && end - begin > best_end - best_begin)) {
+            best_begin = begin;
+            best_end = end;
+            best_rarity = rarity;
+        }
+    }
+    if (best_begin == best_end) return;
+    has_literal = true;
+
+    std::vector<size_t> order;
+    for (size_t j = best_begin; j < best_end; ++j) order.push_back(j);
+    std::stable_sort(order.begin(), order.end(), [&pattern](size_t lhs, size_t rhs) {
+        return frequency(pattern[lhs]) < frequency(pattern[rhs]);
+    });
+    first_offset = order[0];
+    second_offset = order.size() > 1 ? order[1] : order[0];
+}
+
+
+bool TPrefilteredSearch::matches(const char* window) const {
+    for (size_t j = 0; j < pattern.size(); ++j) {
+        if (pattern[j] != '?' && pattern[j] != window[j]) return false;
     }
-    return state[state_ind].next[symbol] = go(get_link(state_ind), symbol);
+    return true;
+}
+
+
+template <typename Callback>
+void TPrefilteredSearch::find(const char* data, size_t size, Callback callback) const {
+    if (pattern.size() > size) return;
+    const size_t last = size - pattern.size(); // последняя возможная позиция начала
+    if (!has_literal) {
+        for (size_t position = 0; position <= last; ++position) callback(position);
+        return;
+    }
+    const char first = pattern[first_offset], second = pattern[second_offset];
+    size_t position = 0;
+#ifdef __AVX2__
+    const __m256i first_vector = _mm256_set1_epi8(first), second_vector = _mm256_set1_epi8(second);
+    for (; position + 31 <= last; position += 32) {
+        __m256i lhs = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + position + first_offset));
+        __m256i rhs = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + position + second_offset));
+        auto candidates = static_cast<uint32_t>(_mm256_movemask_epi8(
+                _mm256_and_si256(_mm256_cmpeq_epi8(lhs, first_vector), _mm256_cmpeq_epi8(rhs, second_vector))));
+        for (; candidates != 0; candidates &= candidates - 1) {
+            size_t candidate = position + __builtin_ctz(candidates);
+            if (matches(data + candidate)) callback(candidate);
+        }
+    }
+#endif
+    while (position <= last) {
+        const void* found = std::memchr(data + position + first_offset, first, last - position + 1);
+        if (found == nullptr) break;
+        position = static_cast<const char*>(found) - data - first_offset;
+        if (data[position + second_offset] == second && matches(data + position)) callback(position);
+        position++;
+    }
+}
+
+
+// Автомат Ахо-Корасик для словаря шаблонов (без '?').
+// Бор строится в плоских массивах: рёбра каждой вершины лежат подряд по возрастанию класса.
+// Если плотная таблица переходов (вершины x классы байтов) не больше DENSE_LIMIT, переходы, суффиксные
+// и выходные ссылки строятся заранее обходом в ширину, и поиск работает за O(|text| + число вхождений).
+// Когда классов много и словарь большой (например, 100k двоичных сигнатур по 16 байт - 1.6M вершин
+// по 257 классов, около 1.6 ГБ), таблица не строится: хранятся только рёбра бора и строка переходов корня,
+// а отсутствующий переход ищется по суффиксным ссылкам двоичным поиском среди рёбер. Память тогда
+// O(суммы длин шаблонов), поиск - O(|text| log 256 + число вхождений) амортизированно.
+struct TAhoCorasick {
+public:
+    struct TMatch {
+        size_t pattern_id;
+        size_t position; // индекс начала вхождения в тексте
+    };
+
+    explicit TAhoCorasick(const std::vector<std::string>& patterns);
+    std::vector<TMatch> find(const std::string& text) const;
+    // callback(pattern_id, position) вызывается для каждого вхождения в порядке их концов.
+    template <typename Callback>
+    void find(const std::string& text, Callback callback) const;
+
+private:
+    static const size_t DENSE_LIMIT = size_t(1) << 24; // переходов в плотной таблице, 64 МБ
+
+    struct TVertex {
+        int link;
+        int output_link; // ближайшая по суффиксным ссылкам вершина, где кончается шаблон
+        int pattern;     // первый из шаблонов, которые кончаются в этой вершине, или -1
+
+        TVertex() : link(0), output_link(-1), pattern(-1) {}
+    };
+
+    struct TEdge {
+        int symbol; // класс байта
+        int child;
+    };
+
+    // Переход из вершины по классу без плотной таблицы.
+    int sparse_go(int current, int symbol) const;
+    template <typename Go, typename Callback>
+    void scan(const std::string& text, Go go, Callback callback) const;
+
+    std::vector<TVertex> state;
+    std::vector<int>     same_end; // same_end[id] - следующий шаблон, который кончается там же, или -1
+    bool                 dense;
+    // Переходы всех вершин в одном массиве: next[v * classes.size + c] - переход из v по классу c.
+    // Без плотной таблицы здесь только строка корня.
+    std::vector<int>     next;
+    // Рёбра бора вершины v - edges[edge_begin[v], edge_begin[v + 1]), только без плотной таблицы.
+    std::vector<size_t>  edge_begin;
+    std::vector<TEdge>   edges;
+    TByteClasses         classes;
+    std::vector<size_t>  pattern_size;
+};
+
+
+TAhoCorasick::TAhoCorasick(const std::vector<std::string>& patterns) : state(1), same_end(patterns.size(), -1) {
+    for (const auto& pattern : patterns) {
+        for (char symbol : pattern) classes.add(symbol);
+    }
+    const size_t alphabet = classes.size;
+
+    // Бор: дети вершины связаны в список через sibling.
+    std::vector<int> first_child(1, -1), sibling(1, -1), income(1, 0), end(patterns.size());
+    for (size_t id = 0; id < patterns.size(); ++id) {
+        int current = 0;
+        for (char symbol : patterns[id]) {
+            int child = first_child[current];
+            while (child != -1 && income[child] != classes(symbol)) child = sibling[child];
+            if (child == -1) {
+                child = state.size();
+                state.emplace_back();
+                first_child.push_back(-1);
+                sibling.push_back(first_child[current]);
+                income.push_back(classes(symbol));
+                first_child[current] = child;
+            }
+            current = child;
+        }
+        end[id] = current;
+        pattern_size.push_back(patterns[id].size());
+    }
+    // Шаблоны одной вершины идут по возрастанию номеров.
+    for (size_t id = patterns.size(); id-- > 0;) {
+        same_end[id] = state[end[id]].pattern;
+        state[end[id]].pattern = id;
+    }
+
+    edge_begin.resize(state.size() + 1);
+    edges.reserve(state.size() - 1);
+    for (size_t v = 0; v < state.size(); ++v) {
+        edge_begin[v] = edges.size();
+        for (int child = first_child[v]; child != -1; child = sibling[child]) edges.push_back({income[child], child});
+        std::sort(edges.begin() + edge_begin[v], edges.end(), [](const TEdge& lhs, const TEdge& rhs) {
+            return lhs.symbol < rhs.symbol;
+        });
+    }
+    edge_begin.back() = edges.size();
+
+    dense = state.size() * alphabet <= DENSE_LIMIT;
+    next.assign(dense ? state.size() * alphabet : alphabet, 0);
+    std::vector<int> queue;
+    for (size_t edge = edge_begin[0]; edge < edge_begin[1]; ++edge) {
+        next[edges[edge].symbol] = edges[edge].child;
+        queue.push_back(edges[edge].child);
+    }
+    // Вершины обходятся по возрастанию глубины, так что ссылки всех более коротких суффиксов уже посчитаны.
+    // Отсутствующие переходы заменяются переходами по суффиксной ссылке.
+    for (size_t head = 0; head < queue.size(); ++head) {
+        int current = queue[head];
+        int link = state[current].link;
+        state[current].output_link = state[link].pattern == -1 ? state[link].output_link : link;
+        if (dense) {
+            std::copy_n(next.begin() + link * alphabet, alphabet, next.begin() + current * alphabet);
+        }
+        for (size_t edge = edge_begin[current]; edge < edge_begin[current + 1]; ++edge) {
+            int symbol = edges[edge].symbol, child = edges[edge].child;
+            state[child].link = dense ? next[link * alphabet + symbol] : sparse_go(link, symbol);
+            if (dense) next[current * alphabet + symbol] = child;
+            queue.push_back(child);
+        }
+    }
+    if (dense) {
+        edge_begin = std::vector<size_t>();
+        edges = std::vector<TEdge>();
+    }
+}
+
+
+int TAhoCorasick::sparse_go(int current, int symbol) const {
+    for (; current != 0; current = state[current].link) {
+        auto begin = edges.begin() + edge_begin[current], end = edges.begin() + edge_begin[current + 1];
+        auto edge = std::lower_bound(begin, end, symbol, [](const TEdge& lhs, int rhs) { return lhs.symbol < rhs; });
+        if (edge != end && edge->symbol == symbol) return edge->child;
+    }
+    return next[symbol];
+}
+
+
+template <typename Go, typename Callback>
+void TAhoCorasick::scan(const std::string& text, Go go, Callback callback) const {
+    int current = 0;
+    for (size_t i = 0; i < text.size(); ++i) {
+        current = go(current, classes(text[i]));
+        int terminal = state[current].pattern == -1 ? state[current].output_link : current;
+        for (; terminal != -1; terminal = state[terminal].output_link) {
+            for (int id = state[terminal].pattern; id != -1; id = same_end[id]) {
+                callback(id, i + 1 - pattern_size[id]);
+            }
+        }
+    }
+}
+
+
+template <typename Callback>
+void TAhoCorasick::find(const std::string& text, Callback callback) const {
+    if (dense) {
+        const size_t alphabet = classes.size;
+        scan(text, [this, alphabet](int current, int symbol) { return next[current * alphabet + symbol]; }, callback);
+    } else {
+        scan(text, [this](int current, int symbol) { return sparse_go(current, symbol); }, callback);
+    }
+}
+
+
+std::vector<TAhoCorasick::TMatch> TAhoCorasick::find(const std::string& text) const {
+    std::vector<TMatch> result;
+    find(text, [&result](size_t pattern_id, size_t position) {
+        result.push_back({pattern_id, position});
+    });
+    return result;
 }
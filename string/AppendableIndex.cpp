@@ -0,0 +1,144 @@
+#ifndef AADS_APPENDABLE_INDEX_CPP
+#define AADS_APPENDABLE_INDEX_CPP
+
+#include <algorithm>
+#include <iterator>
+#include <vector>
+
+#include "PrefFunc.cpp"
+#include "SuffArray + LCP.cpp"
+
+/// \brief: Full-text index over a growing text, e.g. a log. The text is split into consecutive
+/// segments, each with its own suffix array. Appended batch becomes a new segment which absorbs
+/// the trailing segments not larger than twice its size (LSM-style merge), so segment sizes decrease
+/// geometrically: there are O(log N) segments and every symbol is resorted O(log N) times in total.
+/// So appending B symbols costs amortized O(B log N) suffix sorting instead of rebuilding all N symbols.
+/// Occurrences inside segments are found by suffix arrays, occurrences crossing segment borders
+/// by the prefix function on 2 * |pattern| symbols around every border.
+/// Symbols should be in (Symbol(), alphabet_size), Symbol() is used as the sentinel of segments.
+template <typename Symbol = char, typename Index = uint32_t>
+class AppendableIndex {
+public:
+    explicit AppendableIndex(size_t alphabet_size = 256,
+                             SuffixArrayAlgorithm algorithm = SuffixArrayAlgorithm::InducedSorting);
+
+    template <typename It>
+    void Append(It begin, It end);
+    template <typename Container>
+    void Append(const Container& text) { Append(std::begin(text), std::end(text)); }
+
+    // Number of indexed symbols
+    [[nodiscard]] size_t size() const { return size_; }
+    [[nodiscard]] size_t Segments() const { return segments_.size(); }
+
+    template <typename Pattern>
+    [[nodiscard]] size_t Count(const Pattern& pattern) const;
+    // Positions of occurrences in the whole text in increasing order
+    template <typename Pattern>
+    [[nodiscard]] std::vector<size_t> Locate(const Pattern& pattern) const;
+
+private:
+    struct Segment {
+        size_t begin;
+        SuffixArray<std::vector<Symbol>, Index> array; // over the segment text with the sentinel
+
+        [[nodiscard]] size_t size() const { return array.GetText().size() - 1; }
+    };
+
+    // Appends text symbols [begin, end) to out, the range may span several segments
+    void copy_text(size_t begin, size_t end, std::vector<Symbol>& out) const;
+    // Calls callback(position) for occurrences which start in segment i - 1 and end in segment i or later
+    template <typename Pattern, typename Callback>
+    void border_occurrences(const Pattern& pattern, size_t i, Callback callback) const;
+
+    const size_t               ALPHABET_SIZE;
+    const SuffixArrayAlgorithm ALGORITHM;
+    size_t                     size_;
+    std::vector<Segment>       segments_;
+};
+
+template <typename Symbol, typename Index>
+AppendableIndex<Symbol, Index>::AppendableIndex(size_t alphabet_size, SuffixArrayAlgorithm algorithm) :
+                                                ALPHABET_SIZE(alphabet_size), ALGORITHM(algorithm), size_(0) {}
+
+template <typename Symbol, typename Index>
+template <typename It>
+void AppendableIndex<Symbol, Index>::Append(It begin, It end) {
+    std::vector<Symbol> batch(begin, end);
+    if (batch.empty()) return;
+
+    size_t merged = batch.size(), first = segments_.size();
+    while (first > 0 && segments_[first - 1].size() <= 2 * merged) merged += segments_[--first].size();
+
+    std::vector<Symbol> text;
+    text.reserve(merged + 1);
+    for (size_t i = first; i < segments_.size(); ++i) {
+        const auto& segment_text = segments_[i].array.GetText();
+        text.insert(text.end(), segment_text.begin(), segment_text.end() - 1);
+    }
+    text.insert(text.end(), batch.begin(), batch.end());
+    text.push_back(Symbol());
+
+    size_t segment_begin = first < segments_.size() ? segments_[first].begin : size_;
+    SuffixArray<std::vector<Symbol>, Index> array(std::move(text), ALPHABET_SIZE, ALGORITHM);
+    while (segments_.size() > first) segments_.pop_back(); // SuffixArray is not assignable, so no erase
+    segments_.push_back(Segment{segment_begin, std::move(array)});
+    size_ += batch.size();
+}
+
+template <typename Symbol, typename Index>
+void AppendableIndex<Symbol, Index>::copy_text(size_t begin, size_t end, std::vector<Symbol>& out) const {
+    auto it = std::upper_bound(segments_.begin(), segments_.end(), begin,
+                               [](size_t position, const Segment& segment) { return position < segment.begin; });
+    for (size_t i = it - segments_.begin() - 1; begin < end; ++i) {
+        const auto& text = segments_[i].array.GetText();
+        size_t last = std::min(end, segments_[i].begin + segments_[i].size());
+        out.insert(out.end(), text.begin() + (begin - segments_[i].begin), text.begin() + (last - segments_[i].begin));
+        begin = last;
+    }
+}
+
+template <typename Symbol, typename Index>
+template <typename Pattern, typename Callback>
+void AppendableIndex<Symbol, Index>::border_occurrences(const Pattern& pattern, size_t i, Callback callback) const {
+    size_t border = segments_[i].begin, length = pattern.size();
+    size_t window_begin = std::max(segments_[i - 1].begin, border - std::min(border, length - 1));
+    size_t window_end = std::min(size_, border + length - 1);
+    if (window_end - window_begin < length) return;
+
+    std::vector<Symbol> window;
+    copy_text(window_begin, window_end, window);
+    SearchWithPrefixFunc(std::begin(pattern), std::end(pattern), window.begin(), window.end(),
+                         [&](size_t position) {
+                             if (window_begin + position < border) callback(window_begin + position);
+                         });
+}
+
+template <typename Symbol, typename Index>
+template <typename Pattern>
+size_t AppendableIndex<Symbol, Index>::Count(const Pattern& pattern) const {
+    size_t result = 0;
+    if (pattern.size() == 0) return result;
+    for (size_t i = 0; i < segments_.size(); ++i) {
+        result += segments_[i].array.Count(pattern);
+        if (i > 0 && pattern.size() > 1) border_occurrences(pattern, i, [&result](size_t) { result++; });
+    }
+    return result;
+}
+
+template <typename Symbol, typename Index>
+template <typename Pattern>
+std::vector<size_t> AppendableIndex<Symbol, Index>::Locate(const Pattern& pattern) const {
+    std::vector<size_t> result;
+    if (pattern.size() == 0) return result;
+    for (size_t i = 0; i < segments_.size(); ++i) {
+        for (auto position : segments_[i].array.Locate(pattern)) result.push_back(segments_[i].begin + position);
+        if (i > 0 && pattern.size() > 1) {
+            border_occurrences(pattern, i, [&result](size_t position) { result.push_back(position); });
+        }
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+#endif //AADS_APPENDABLE_INDEX_CPP
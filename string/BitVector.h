@@ -0,0 +1,53 @@
+#ifndef AADS_BIT_VECTOR_H
+#define AADS_BIT_VECTOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/// \brief: Static bit vector with O(1) rank. Cumulative counts are stored for every block of
+/// WORDS_PER_BLOCK 64-bit words (12.5% overhead), the rest is counted with popcount.
+/// BuildRank should be called after all bits are set.
+class BitVector {
+public:
+    BitVector() : size_(0) {}
+    explicit BitVector(size_t size) : words_((size + 63) / 64), size_(size) {}
+
+    void Set(size_t i) { words_[i / 64] |= uint64_t(1) << (i % 64); }
+    bool operator[](size_t i) const { return (words_[i / 64] >> (i % 64)) & 1; }
+
+    void BuildRank() {
+        blocks_.assign(words_.size() / WORDS_PER_BLOCK + 1, 0);
+        uint64_t ones = 0;
+        for (size_t word = 0; word < words_.size(); ++word) {
+            if (word % WORDS_PER_BLOCK == 0) blocks_[word / WORDS_PER_BLOCK] = ones;
+            ones += __builtin_popcountll(words_[word]);
+        }
+        if (words_.size() % WORDS_PER_BLOCK == 0) blocks_.back() = ones;
+    }
+
+    // Number of ones in [0, i)
+    [[nodiscard]] size_t Rank1(size_t i) const {
+        size_t word = i / 64;
+        size_t result = blocks_[word / WORDS_PER_BLOCK];
+        for (size_t w = word - word % WORDS_PER_BLOCK; w < word; ++w) result += __builtin_popcountll(words_[w]);
+        if (i % 64 != 0) result += __builtin_popcountll(words_[word] & ((uint64_t(1) << (i % 64)) - 1));
+        return result;
+    }
+    // Number of zeros in [0, i)
+    [[nodiscard]] size_t Rank0(size_t i) const { return i - Rank1(i); }
+
+    [[nodiscard]] size_t size() const { return size_; }
+    [[nodiscard]] size_t MemoryUsage() const {
+        return words_.size() * sizeof(uint64_t) + blocks_.size() * sizeof(uint64_t);
+    }
+
+private:
+    static const size_t WORDS_PER_BLOCK = 8;
+
+    std::vector<uint64_t> words_;
+    std::vector<uint64_t> blocks_;
+    size_t size_;
+};
+
+#endif //AADS_BIT_VECTOR_H
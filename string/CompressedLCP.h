@@ -0,0 +1,118 @@
+#ifndef AADS_COMPRESSED_LCP_H
+#define AADS_COMPRESSED_LCP_H
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+#include "BitVector.h"
+
+/// \brief: LCP array of one byte per value. Values from ESCAPE on are stored as ESCAPE, the actual value
+/// is kept in the overflow table at the rank of its position among escaped ones, so access is O(1).
+/// Takes N * (1 + 1.125 / 8) bytes plus 2 * sizeof(Index) per escaped value, which are rare in real texts.
+template <typename Index = uint32_t>
+class CompressedLCP {
+public:
+    static const uint8_t ESCAPE = 255;
+
+    // Sequential access without rank queries: the iterator keeps position in the overflow table
+    class const_iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type        = Index;
+        using difference_type   = std::ptrdiff_t;
+        using pointer           = const Index*;
+        using reference         = Index;
+
+        const_iterator(const CompressedLCP* lcp, size_t position, size_t overflow) :
+                       lcp_(lcp), position_(position), overflow_(overflow) {}
+        Index operator*() const {
+            uint8_t value = lcp_->bytes_[position_];
+            return value != ESCAPE ? value : lcp_->values_[overflow_];
+        }
+        const_iterator& operator++() {
+            overflow_ += lcp_->bytes_[position_++] == ESCAPE;
+            return *this;
+        }
+        bool operator==(const const_iterator& other) const { return position_ == other.position_; }
+        bool operator!=(const const_iterator& other) const { return position_ != other.position_; }
+
+    private:
+        const CompressedLCP* lcp_;
+        size_t position_;
+        size_t overflow_;
+    };
+
+    CompressedLCP() = default;
+    // Zero values to be filled with Set in any order, each position at most once, and then Finish
+    explicit CompressedLCP(size_t size) : bytes_(size) {}
+
+    template <typename Values>
+    static CompressedLCP Compress(const Values& values) {
+        CompressedLCP result(values.size());
+        for (size_t i = 0; i < values.size(); ++i) result.Set(i, values[i]);
+        result.Finish();
+        return result;
+    }
+
+    void Set(size_t i, Index value) {
+        if (value < ESCAPE) {
+            bytes_[i] = value;
+        } else {
+            bytes_[i] = ESCAPE;
+            overflow_.emplace_back(i, value);
+        }
+    }
+    // Builds the overflow table, should be called after all Set calls
+    void Finish();
+
+    Index operator[](size_t i) const {
+        return bytes_[i] != ESCAPE ? bytes_[i] : values_[escaped_.Rank1(i)];
+    }
+    // Writes values [begin, end) to out. Bytes are widened in a plain loop which compilers vectorize,
+    // then escaped values are patched.
+    void Decode(size_t begin, size_t end, Index* out) const;
+
+    [[nodiscard]] size_t size() const { return bytes_.size(); }
+    [[nodiscard]] bool empty() const { return bytes_.empty(); }
+    [[nodiscard]] const_iterator begin() const { return const_iterator(this, 0, 0); }
+    [[nodiscard]] const_iterator end() const { return const_iterator(this, size(), values_.size()); }
+    [[nodiscard]] size_t MemoryUsage() const {
+        return bytes_.size() + escaped_.MemoryUsage() + (positions_.size() + values_.size()) * sizeof(Index);
+    }
+
+private:
+    std::vector<uint8_t> bytes_;
+    BitVector            escaped_;
+    std::vector<Index>   positions_; // escaped positions in increasing order
+    std::vector<Index>   values_;    // their values
+    std::vector<std::pair<Index, Index>> overflow_; // escaped (position, value) pairs before Finish
+};
+
+template <typename Index>
+void CompressedLCP<Index>::Finish() {
+    std::sort(overflow_.begin(), overflow_.end());
+    escaped_ = BitVector(bytes_.size());
+    positions_.clear();
+    values_.clear();
+    for (const auto& [position, value] : overflow_) {
+        escaped_.Set(position);
+        positions_.push_back(position);
+        values_.push_back(value);
+    }
+    escaped_.BuildRank();
+    overflow_ = std::vector<std::pair<Index, Index>>();
+}
+
+template <typename Index>
+void CompressedLCP<Index>::Decode(size_t begin, size_t end, Index* out) const {
+    const uint8_t* bytes = bytes_.data();
+    for (size_t i = begin; i < end; ++i) out[i - begin] = bytes[i];
+    for (size_t k = escaped_.Rank1(begin); k < positions_.size() && positions_[k] < end; ++k) {
+        out[positions_[k] - begin] = values_[k];
+    }
+}
+
+#endif //AADS_COMPRESSED_LCP_H
@@ -0,0 +1,178 @@
+#ifndef AADS_ENHANCED_SUFFIX_ARRAY_CPP
+#define AADS_ENHANCED_SUFFIX_ARRAY_CPP
+
+#include <algorithm>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#include "SuffArray + LCP.cpp"
+
+/// \brief: Repeat analytics of a text from its suffix array and LCP (enhanced suffix array, Abouelhoda et al.).
+/// LCP intervals are the internal nodes of the suffix tree, they are visited bottom-up with a stack in one
+/// O(N) pass which finds the longest repeated substring, the number of distinct substrings, maximal repeats
+/// (repeats which can't be extended to the left or to the right keeping all occurrences) and supermaximal
+/// repeats (maximal repeats which are not substrings of other maximal ones).
+/// Text should end with the unique sentinel as for SuffixArray, substrings with the sentinel are not counted.
+/// The suffix array and its LCP (plain, compressed or packed) are read in place, so the suffix array should outlive
+/// this object and should not be rebuilt. The suffix array itself should not be packed.
+template <typename Container, typename Index = uint32_t>
+class EnhancedSuffixArray {
+public:
+    // Substring of the given length which occurs at positions array[begin, end)
+    struct Repeat {
+        size_t length;
+        size_t begin;
+        size_t end;
+
+        [[nodiscard]] size_t Occurrences() const { return end - begin; }
+    };
+
+    // Builds LCP if it is not built yet
+    explicit EnhancedSuffixArray(SuffixArray<Container, Index>& suffix_array);
+
+    // Empty repeat (length 0) if no symbol occurs twice
+    [[nodiscard]] const Repeat& LongestRepeat() const { return longest_; }
+    [[nodiscard]] uint64_t DistinctSubstrings() const { return distinct_; }
+    // Repeats in bottom-up order of the intervals, i.e. longer ones go before their prefixes
+    [[nodiscard]] const std::vector<Repeat>& MaximalRepeats() const { return maximal_; }
+    [[nodiscard]] const std::vector<Repeat>& SupermaximalRepeats() const { return supermaximal_; }
+
+    // Positions of the repeat in the text in increasing order
+    [[nodiscard]] std::vector<Index> Positions(const Repeat& repeat) const;
+    [[nodiscard]] const SuffixArray<Container, Index>& GetSuffixArray() const { return suffix_array_; }
+
+private:
+    using Symbol = typename std::decay<decltype(std::declval<const Container&>()[0])>::type;
+
+    // Symbols preceding the suffixes of an interval: none yet, all equal to symbol, or different
+    struct LeftContext {
+        enum { EMPTY, SAME, DIVERSE } state;
+        Symbol symbol;
+
+        void Merge(const LeftContext& other);
+    };
+
+    struct Interval {
+        size_t      lcp;
+        size_t      begin;
+        LeftContext left;
+        bool        has_children; // has child intervals, not only single suffixes
+    };
+
+    // LCP is the plain LCP view, CompressedLCP or PackedArray
+    template <typename LCP>
+    void analyze(const Container& text, const LCP& lcp_array);
+    // Single suffix contexts are pairwise different, suffix at 0 has a unique one. Symbols are scratch memory.
+    [[nodiscard]] bool distinct_left(const Container& text, size_t begin, size_t end,
+                                     std::vector<Symbol>& symbols) const;
+
+    const SuffixArray<Container, Index>& suffix_array_;
+    ArrayView<Index>    array_;
+    Repeat              longest_{0, 0, 0};
+    uint64_t            distinct_ = 0;
+    std::vector<Repeat> maximal_;
+    std::vector<Repeat> supermaximal_;
+};
+
+template <typename Container, typename Index>
+void EnhancedSuffixArray<Container, Index>::LeftContext::Merge(const LeftContext& other) {
+    if (other.state == EMPTY || state == DIVERSE) return;
+    if (state == EMPTY || other.state == DIVERSE) {
+        *this = other;
+    } else if (!(symbol == other.symbol)) {
+        state = DIVERSE;
+    }
+}
+
+template <typename Container, typename Index>
+EnhancedSuffixArray<Container, Index>::EnhancedSuffixArray(SuffixArray<Container, Index>& suffix_array) :
+                                                           suffix_array_(suffix_array),
+                                                           array_(suffix_array.GetArrayView()) {
+    if (!suffix_array.GetPackedArray().empty()) {
+        throw std::logic_error("EnhancedSuffixArray: suffix array is packed");
+    }
+    if (suffix_array.GetLCPView().size() != array_.size() &&
+        suffix_array.GetCompressedLCP().size() != array_.size() &&
+        suffix_array.GetPackedLCP().size() != array_.size()) {
+        suffix_array.BuildLCP();
+    }
+    if (!suffix_array.GetCompressedLCP().empty()) {
+        analyze(suffix_array.GetText(), suffix_array.GetCompressedLCP());
+    } else if (!suffix_array.GetPackedLCP().empty()) {
+        analyze(suffix_array.GetText(), suffix_array.GetPackedLCP());
+    } else {
+        analyze(suffix_array.GetText(), suffix_array.GetLCPView());
+    }
+}
+
+template <typename Container, typename Index>
+template <typename LCP>
+void EnhancedSuffixArray<Container, Index>::analyze(const Container& text, const LCP& lcp_array) {
+    size_t size = array_.size();
+    auto leaf = [&](size_t i) {
+        if (array_[i] == 0) return LeftContext{LeftContext::DIVERSE, Symbol()};
+        return LeftContext{LeftContext::SAME, text[array_[i] - 1]};
+    };
+
+    std::vector<Interval> stack = {{0, 0, {LeftContext::EMPTY, Symbol()}, false}};
+    std::vector<Symbol> symbols;
+    for (size_t i = 1; i <= size; ++i) {
+        // Suffix i - 1 without the sentinel is a prefix of the suffix i - 1 plus lcp new substrings
+        size_t lcp = i < size ? lcp_array[i] : 0;
+        distinct_ += size - 1 - array_[i - 1] - lcp_array[i - 1];
+        if (lcp_array[i - 1] > longest_.length) longest_ = {lcp_array[i - 1], i - 2, i};
+
+        stack.back().left.Merge(leaf(i - 1));
+        size_t begin = i - 1;
+        bool popped = false;
+        LeftContext last{LeftContext::EMPTY, Symbol()};
+        while (lcp < stack.back().lcp) {
+            Interval interval = stack.back();
+            stack.pop_back();
+            if (interval.left.state == LeftContext::DIVERSE) maximal_.push_back({interval.lcp, interval.begin, i});
+            if (!interval.has_children && distinct_left(text, interval.begin, i, symbols)) {
+                supermaximal_.push_back({interval.lcp, interval.begin, i});
+            }
+            begin = interval.begin;
+            if (lcp <= stack.back().lcp) {
+                // The interval is a child of the new top
+                stack.back().left.Merge(interval.left);
+                stack.back().has_children = true;
+                popped = false;
+            } else {
+                // ... or of the interval pushed below
+                last = interval.left;
+                popped = true;
+            }
+        }
+        if (lcp > stack.back().lcp) {
+            stack.push_back({lcp, begin, popped ? last : leaf(i - 1), popped});
+        }
+    }
+    // Longest repeat range is extended to all its occurrences
+    if (longest_.length > 0) {
+        while (longest_.begin > 0 && lcp_array[longest_.begin] >= longest_.length) longest_.begin--;
+        while (longest_.end < size && lcp_array[longest_.end] >= longest_.length) longest_.end++;
+    }
+}
+
+template <typename Container, typename Index>
+bool EnhancedSuffixArray<Container, Index>::distinct_left(const Container& text, size_t begin, size_t end,
+                                                          std::vector<Symbol>& symbols) const {
+    symbols.clear();
+    for (size_t i = begin; i < end; ++i) {
+        if (array_[i] != 0) symbols.push_back(text[array_[i] - 1]);
+    }
+    std::sort(symbols.begin(), symbols.end());
+    return std::adjacent_find(symbols.begin(), symbols.end()) == symbols.end();
+}
+
+template <typename Container, typename Index>
+std::vector<Index> EnhancedSuffixArray<Container, Index>::Positions(const Repeat& repeat) const {
+    std::vector<Index> result(array_.begin() + repeat.begin, array_.begin() + repeat.end);
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+#endif //AADS_ENHANCED_SUFFIX_ARRAY_CPP
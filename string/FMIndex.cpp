@@ -0,0 +1,205 @@
+#ifndef AADS_FM_INDEX_CPP
+#define AADS_FM_INDEX_CPP
+
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+#include "BitVector.h"
+#include "SuffArray + LCP.cpp"
+
+/// \brief: Wavelet matrix over codes in [0, alphabet_size). Stores ceil(log2 sigma) bit vectors of N bits.
+/// On every level the sequence is stably partitioned by the current bit (zeros first), starting from the highest one.
+class WaveletMatrix {
+public:
+    WaveletMatrix() : size_(0) {}
+    WaveletMatrix(std::vector<uint32_t> codes, size_t alphabet_size);
+
+    // Number of code occurrences in [0, i)
+    [[nodiscard]] size_t Rank(uint32_t code, size_t i) const;
+    // Code at position i and the number of its occurrences in [0, i)
+    [[nodiscard]] std::pair<uint32_t, size_t> AccessRank(size_t i) const;
+
+    [[nodiscard]] size_t MemoryUsage() const;
+
+private:
+    size_t                 size_;
+    std::vector<BitVector> levels_;
+    std::vector<size_t>    zeros_;  // number of zeros on every level
+    std::vector<size_t>    bottom_; // position of the first code occurrence after the last level
+};
+
+inline WaveletMatrix::WaveletMatrix(std::vector<uint32_t> codes, size_t alphabet_size) : size_(codes.size()) {
+    size_t height = 1;
+    while ((size_t(1) << height) < alphabet_size) height++;
+    std::vector<uint32_t> zeros, ones;
+    for (size_t level = 0; level < height; ++level) {
+        size_t bit = height - 1 - level;
+        levels_.emplace_back(size_);
+        zeros.clear();
+        ones.clear();
+        for (size_t i = 0; i < size_; ++i) {
+            if ((codes[i] >> bit) & 1) {
+                levels_.back().Set(i);
+                ones.push_back(codes[i]);
+            } else {
+                zeros.push_back(codes[i]);
+            }
+        }
+        levels_.back().BuildRank();
+        zeros_.push_back(zeros.size());
+        std::copy(ones.begin(), ones.end(), std::copy(zeros.begin(), zeros.end(), codes.begin()));
+    }
+    bottom_.assign(alphabet_size, size_);
+    for (size_t i = size_; i > 0; --i) bottom_[codes[i - 1]] = i - 1;
+}
+
+inline size_t WaveletMatrix::Rank(uint32_t code, size_t i) const {
+    for (size_t level = 0; level < levels_.size(); ++level) {
+        if ((code >> (levels_.size() - 1 - level)) & 1) {
+            i = zeros_[level] + levels_[level].Rank1(i);
+        } else {
+            i = levels_[level].Rank0(i);
+        }
+    }
+    return i - bottom_[code];
+}
+
+inline std::pair<uint32_t, size_t> WaveletMatrix::AccessRank(size_t i) const {
+    uint32_t code = 0;
+    for (size_t level = 0; level < levels_.size(); ++level) {
+        code <<= 1;
+        if (levels_[level][i]) {
+            code |= 1;
+            i = zeros_[level] + levels_[level].Rank1(i);
+        } else {
+            i = levels_[level].Rank0(i);
+        }
+    }
+    return {code, i - bottom_[code]};
+}
+
+inline size_t WaveletMatrix::MemoryUsage() const {
+    size_t result = zeros_.size() * sizeof(size_t) + bottom_.size() * sizeof(size_t);
+    for (const auto& level : levels_) result += level.MemoryUsage();
+    return result;
+}
+
+/// \brief: FM-index: compressed full-text index over the BWT of a sentinel-terminated text.
+/// Counting is a backward search and does not need the text. Locate walks LF-mapping to the
+/// nearest sampled text position, every SAMPLE_RATE-th position of the text is sampled.
+/// Memory: N * ceil(log2 sigma) * 1.125 bits for the BWT, N bits + N / SAMPLE_RATE indices for samples.
+template <typename Symbol = char, typename Index = uint32_t>
+class FMIndex {
+public:
+    // The suffix array should not be packed, std::logic_error is thrown otherwise
+    template <typename Container, typename SAIndex>
+    explicit FMIndex(const SuffixArray<Container, SAIndex>& suffix_array, size_t sample_rate = 32);
+
+    // Range of the pattern in the suffix array, empty if there are no occurrences
+    template <typename Pattern>
+    [[nodiscard]] std::pair<size_t, size_t> Range(const Pattern& pattern) const;
+    template <typename Pattern>
+    [[nodiscard]] size_t Count(const Pattern& pattern) const;
+    // Positions of occurrences in suffix array order, O(SAMPLE_RATE) per occurrence
+    template <typename Pattern>
+    [[nodiscard]] std::vector<Index> Locate(const Pattern& pattern) const;
+
+    [[nodiscard]] size_t size() const { return size_; }
+    [[nodiscard]] size_t MemoryUsage() const;
+
+private:
+    // Code of the symbol or alphabet size if it does not occur in the text
+    [[nodiscard]] uint32_t code(const Symbol& symbol) const;
+    // Order of symbols in the suffix array (see UnsignedSymbol)
+    static bool less(const Symbol& lhs, const Symbol& rhs) { return UnsignedSymbol(lhs) < UnsignedSymbol(rhs); }
+
+    const size_t          SAMPLE_RATE;
+    size_t                size_;
+    std::vector<Symbol>   symbols_; // distinct symbols in suffix array order, code is the index here
+    std::vector<size_t>   count_;   // count_[c] - number of symbols with code less than c
+    WaveletMatrix         bwt_;
+    BitVector             sampled_; // suffix array positions with sampled text positions
+    std::vector<Index>    samples_;
+};
+
+template <typename Symbol, typename Index>
+template <typename Container, typename SAIndex>
+FMIndex<Symbol, Index>::FMIndex(const SuffixArray<Container, SAIndex>& suffix_array, size_t sample_rate) :
+                                SAMPLE_RATE(std::max<size_t>(sample_rate, 1)) {
+    const auto& text = suffix_array.GetText();
+    if (!suffix_array.GetPackedArray().empty()) throw std::logic_error("FMIndex: suffix array is packed");
+    const auto array = suffix_array.GetArrayView();
+    size_ = array.size();
+
+    symbols_.assign(text.begin(), text.end());
+    std::sort(symbols_.begin(), symbols_.end(), less);
+    symbols_.erase(std::unique(symbols_.begin(), symbols_.end()), symbols_.end());
+
+    std::vector<uint32_t> bwt(size_);
+    count_.assign(symbols_.size() + 1, 0);
+    sampled_ = BitVector(size_);
+    for (size_t i = 0; i < size_; ++i) {
+        bwt[i] = code(text[array[i] == 0 ? size_ - 1 : array[i] - 1]);
+        count_[bwt[i] + 1]++;
+        if (array[i] % SAMPLE_RATE == 0) sampled_.Set(i);
+    }
+    for (size_t c = 1; c < count_.size(); ++c) count_[c] += count_[c - 1];
+    sampled_.BuildRank();
+    for (size_t i = 0; i < size_; ++i) {
+        if (array[i] % SAMPLE_RATE == 0) samples_.push_back(array[i]);
+    }
+    bwt_ = WaveletMatrix(std::move(bwt), symbols_.size());
+}
+
+template <typename Symbol, typename Index>
+uint32_t FMIndex<Symbol, Index>::code(const Symbol& symbol) const {
+    auto it = std::lower_bound(symbols_.begin(), symbols_.end(), symbol, less);
+    return it != symbols_.end() && *it == symbol ? it - symbols_.begin() : symbols_.size();
+}
+
+template <typename Symbol, typename Index>
+template <typename Pattern>
+std::pair<size_t, size_t> FMIndex<Symbol, Index>::Range(const Pattern& pattern) const {
+    size_t begin = 0, end = size_;
+    for (size_t i = pattern.size(); i > 0 && begin < end; --i) {
+        uint32_t c = code(pattern[i - 1]);
+        if (c == symbols_.size()) return {0, 0};
+        begin = count_[c] + bwt_.Rank(c, begin);
+        end = count_[c] + bwt_.Rank(c, end);
+    }
+    return begin < end ? std::make_pair(begin, end) : std::make_pair(size_t(0), size_t(0));
+}
+
+template <typename Symbol, typename Index>
+template <typename Pattern>
+size_t FMIndex<Symbol, Index>::Count(const Pattern& pattern) const {
+    auto range = Range(pattern);
+    return range.second - range.first;
+}
+
+template <typename Symbol, typename Index>
+template <typename Pattern>
+std::vector<Index> FMIndex<Symbol, Index>::Locate(const Pattern& pattern) const {
+    auto range = Range(pattern);
+    std::vector<Index> result;
+    result.reserve(range.second - range.first);
+    for (size_t i = range.first; i < range.second; ++i) {
+        size_t row = i, steps = 0;
+        while (!sampled_[row]) {
+            auto symbol = bwt_.AccessRank(row);
+            row = count_[symbol.first] + symbol.second; // LF-mapping: row of the suffix one symbol to the left
+            steps++;
+        }
+        result.push_back(samples_[sampled_.Rank1(row)] + steps);
+    }
+    return result;
+}
+
+template <typename Symbol, typename Index>
+size_t FMIndex<Symbol, Index>::MemoryUsage() const {
+    return symbols_.size() * sizeof(Symbol) + count_.size() * sizeof(size_t) + bwt_.MemoryUsage() +
+           sampled_.MemoryUsage() + samples_.size() * sizeof(Index);
+}
+
+#endif //AADS_FM_INDEX_CPP
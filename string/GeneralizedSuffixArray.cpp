@@ -0,0 +1,245 @@
+#ifndef AADS_GENERALIZED_SUFFIX_ARRAY_CPP
+#define AADS_GENERALIZED_SUFFIX_ARRAY_CPP
+
+#include <algorithm>
+#include <iterator>
+#include <type_traits>
+#include <vector>
+
+#include "BitVector.h"
+#include "SuffArray + LCP.cpp"
+
+/// \brief: Read-only view of documents d_0, ..., d_{D-1} as one string d_0 $_0 d_1 $_1 ... d_{D-1} $_{D-1}
+/// over the integer alphabet [0, D + alphabet_size). Separators are distinct and less than any symbol,
+/// $_d = D - 1 - d, so the last one is the usual sentinel and common prefixes never cross documents.
+/// Symbol c is mapped to D + c. Documents are not copied and should outlive the view, the position
+/// to document mapping takes N bits with rank (see BitVector).
+template <typename Documents>
+class DocumentsView {
+public:
+    using Symbol = typename std::decay<decltype(std::declval<const Documents&>()[0][0])>::type;
+
+    class const_iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type        = size_t;
+        using difference_type   = std::ptrdiff_t;
+        using pointer           = const size_t*;
+        using reference         = size_t;
+
+        const_iterator(const DocumentsView* view, size_t position) : view_(view), position_(position) {}
+        size_t operator*() const { return (*view_)[position_]; }
+        const_iterator& operator++() { position_++; return *this; }
+        bool operator==(const const_iterator& other) const { return position_ == other.position_; }
+        bool operator!=(const const_iterator& other) const { return position_ != other.position_; }
+
+    private:
+        const DocumentsView* view_;
+        size_t position_;
+    };
+
+    explicit DocumentsView(const Documents& documents);
+
+    size_t operator[](size_t i) const {
+        size_t document = Document(i), offset = i - starts_[document];
+        if (offset == (*documents_)[document].size()) return starts_.size() - 1 - document;
+        return starts_.size() + static_cast<typename std::make_unsigned<Symbol>::type>((*documents_)[document][offset]);
+    }
+    [[nodiscard]] size_t size() const { return size_; }
+    [[nodiscard]] const_iterator begin() const { return const_iterator(this, 0); }
+    [[nodiscard]] const_iterator end() const { return const_iterator(this, size_); }
+
+    [[nodiscard]] size_t DocumentCount() const { return starts_.size(); }
+    // Document which position i belongs to, its separator belongs to it too
+    [[nodiscard]] size_t Document(size_t i) const { return starts_bits_.Rank1(i + 1) - 1; }
+    // Position of the first symbol of the document in the concatenation
+    [[nodiscard]] size_t Start(size_t document) const { return starts_[document]; }
+
+private:
+    const Documents*    documents_;
+    size_t              size_;
+    std::vector<size_t> starts_;
+    BitVector           starts_bits_;
+};
+
+template <typename Documents>
+DocumentsView<Documents>::DocumentsView(const Documents& documents) : documents_(&documents), size_(0) {
+    starts_.reserve(documents.size());
+    for (const auto& document : documents) {
+        starts_.push_back(size_);
+        size_ += document.size() + 1;
+    }
+    starts_bits_ = BitVector(size_);
+    for (auto start : starts_) starts_bits_.Set(start);
+    starts_bits_.BuildRank();
+}
+
+/// \brief: Generalized suffix array of a document collection. Suffixes of all documents are sorted together
+/// over a DocumentsView, so no concatenated copy is built and LCP stops at document ends.
+/// Besides SA and LCP it stores the document array: id of the document of every suffix array entry.
+/// Document listing (distinct documents containing a pattern) is O(m log n + ndoc) after BuildDocumentListing
+/// with Muthukrishnan's algorithm: entry i reports its document if the previous entry of the same document
+/// is before the pattern range, such entries are found by range minimum queries over the previous entries.
+template <typename Documents, typename Index = uint32_t>
+class GeneralizedSuffixArray {
+public:
+    // Documents of arbitrary integer symbols, e.g. token ids, can be indexed with COMPACT_ALPHABET
+    explicit GeneralizedSuffixArray(const Documents& documents, size_t alphabet_size = 256,
+                                    SuffixArrayAlgorithm algorithm = SuffixArrayAlgorithm::InducedSorting);
+
+    void BuildLCP(LCPAlgorithm algorithm = LCPAlgorithm::Kasai, LCPStorage storage = LCPStorage::Plain) {
+        array_.BuildLCP(algorithm, storage);
+    }
+    void BuildLCPLR() { array_.BuildLCPLR(); }
+    void BuildDocumentListing();
+
+    [[nodiscard]] size_t DocumentCount() const { return array_.GetText().DocumentCount(); }
+    [[nodiscard]] std::vector<Index> GetArray() const { return array_.GetArray(); }
+    [[nodiscard]] std::vector<Index> GetLCP() const { return array_.GetLCP(); }
+    [[nodiscard]] ArrayView<Index> GetArrayView() const { return array_.GetArrayView(); }
+    [[nodiscard]] ArrayView<Index> GetLCPView() const { return array_.GetLCPView(); }
+    [[nodiscard]] const std::vector<Index>& GetDocumentArray() const { return documents_; }
+    // Document and offset in it of the position in the concatenation
+    [[nodiscard]] std::pair<size_t, size_t> Resolve(size_t position) const;
+
+    // Pattern is a sequence of document symbols
+    template <typename Pattern>
+    [[nodiscard]] std::pair<size_t, size_t> Range(const Pattern& pattern) const;
+    template <typename Pattern>
+    [[nodiscard]] size_t Count(const Pattern& pattern) const;
+    // Occurrences as (document, offset) pairs in suffix array order
+    template <typename Pattern>
+    [[nodiscard]] std::vector<std::pair<size_t, size_t>> Locate(const Pattern& pattern) const;
+    // Distinct documents containing the pattern
+    template <typename Pattern>
+    [[nodiscard]] std::vector<Index> ListDocuments(const Pattern& pattern) const;
+    // At most k documents with the most occurrences of the pattern as (document, occurrences),
+    // ordered by occurrences descending and then by document id, O(m log n + occ log occ)
+    template <typename Pattern>
+    [[nodiscard]] std::vector<std::pair<Index, size_t>> TopK(const Pattern& pattern, size_t k) const;
+
+private:
+    // Pattern symbols mapped to the alphabet of DocumentsView
+    template <typename Pattern>
+    struct MappedPattern {
+        const Pattern& pattern;
+        size_t shift;
+
+        [[nodiscard]] size_t size() const { return pattern.size(); }
+        size_t operator[](size_t i) const {
+            using Symbol = typename std::decay<decltype(pattern[i])>::type;
+            return shift + static_cast<typename std::make_unsigned<Symbol>::type>(pattern[i]);
+        }
+    };
+
+    SuffixArray<DocumentsView<Documents>, Index> array_;
+    std::vector<Index>  documents_;
+    std::vector<Index>  previous_; // 1 + previous entry of the same document, 0 if there is none
+    RangeMinimum<Index> previous_rmq_;
+};
+
+template <typename Documents, typename Index>
+GeneralizedSuffixArray<Documents, Index>::GeneralizedSuffixArray(const Documents& documents, size_t alphabet_size,
+                                                                  SuffixArrayAlgorithm algorithm) :
+        array_(DocumentsView<Documents>(documents),
+               alphabet_size == COMPACT_ALPHABET ? COMPACT_ALPHABET : documents.size() + alphabet_size, algorithm) {
+    const auto& view = array_.GetText();
+    const auto array = array_.GetArrayView();
+    documents_.resize(array.size());
+    for (size_t i = 0; i < array.size(); ++i) documents_[i] = view.Document(array[i]);
+}
+
+template <typename Documents, typename Index>
+void GeneralizedSuffixArray<Documents, Index>::BuildDocumentListing() {
+    std::vector<Index> last(DocumentCount(), 0);
+    previous_.resize(documents_.size());
+    for (size_t i = 0; i < documents_.size(); ++i) {
+        previous_[i] = last[documents_[i]];
+        last[documents_[i]] = i + 1;
+    }
+    previous_rmq_ = RangeMinimum<Index>(previous_);
+}
+
+template <typename Documents, typename Index>
+std::pair<size_t, size_t> GeneralizedSuffixArray<Documents, Index>::Resolve(size_t position) const {
+    size_t document = array_.GetText().Document(position);
+    return {document, position - array_.GetText().Start(document)};
+}
+
+template <typename Documents, typename Index>
+template <typename Pattern>
+std::pair<size_t, size_t> GeneralizedSuffixArray<Documents, Index>::Range(const Pattern& pattern) const {
+    if (pattern.size() == 0) return {0, 0};
+    return array_.Range(MappedPattern<Pattern>{pattern, DocumentCount()});
+}
+
+template <typename Documents, typename Index>
+template <typename Pattern>
+size_t GeneralizedSuffixArray<Documents, Index>::Count(const Pattern& pattern) const {
+    auto range = Range(pattern);
+    return range.second - range.first;
+}
+
+template <typename Documents, typename Index>
+template <typename Pattern>
+std::vector<std::pair<size_t, size_t>> GeneralizedSuffixArray<Documents, Index>::Locate(const Pattern& pattern) const {
+    std::vector<std::pair<size_t, size_t>> result;
+    if (pattern.size() == 0) return result;
+    for (auto position : array_.Locate(MappedPattern<Pattern>{pattern, DocumentCount()})) {
+        result.push_back(Resolve(position));
+    }
+    return result;
+}
+
+template <typename Documents, typename Index>
+template <typename Pattern>
+std::vector<Index> GeneralizedSuffixArray<Documents, Index>::ListDocuments(const Pattern& pattern) const {
+    auto range = Range(pattern);
+    std::vector<Index> result;
+    if (range.first == range.second) return result;
+    if (previous_.empty()) {
+        // Without BuildDocumentListing every occurrence is checked
+        std::vector<bool> seen(DocumentCount());
+        for (size_t i = range.first; i < range.second; ++i) {
+            if (!seen[documents_[i]]) {
+                seen[documents_[i]] = true;
+                result.push_back(documents_[i]);
+            }
+        }
+        return result;
+    }
+    std::vector<std::pair<size_t, size_t>> intervals = {{range.first, range.second - 1}};
+    while (!intervals.empty()) {
+        auto [left, right] = intervals.back();
+        intervals.pop_back();
+        size_t minimum = previous_rmq_.Query(previous_, left, right);
+        if (previous_[minimum] > range.first) continue; // every document here was reported before the range
+        result.push_back(documents_[minimum]);
+        if (minimum < right) intervals.emplace_back(minimum + 1, right);
+        if (minimum > left) intervals.emplace_back(left, minimum - 1);
+    }
+    return result;
+}
+
+template <typename Documents, typename Index>
+template <typename Pattern>
+std::vector<std::pair<Index, size_t>> GeneralizedSuffixArray<Documents, Index>::TopK(const Pattern& pattern,
+                                                                                     size_t k) const {
+    auto range = Range(pattern);
+    std::vector<Index> occurrences(documents_.begin() + range.first, documents_.begin() + range.second);
+    std::sort(occurrences.begin(), occurrences.end());
+    std::vector<std::pair<Index, size_t>> result;
+    for (size_t i = 0, j = 0; i < occurrences.size(); i = j) {
+        while (j < occurrences.size() && occurrences[j] == occurrences[i]) j++;
+        result.emplace_back(occurrences[i], j - i);
+    }
+    auto better = [](const std::pair<Index, size_t>& lhs, const std::pair<Index, size_t>& rhs) {
+        return lhs.second != rhs.second ? lhs.second > rhs.second : lhs.first < rhs.first;
+    };
+    k = std::min(k, result.size());
+    std::partial_sort(result.begin(), result.begin() + k, result.end(), better);
+    result.resize(k);
+    return result;
+}
+
+#endif //AADS_GENERALIZED_SUFFIX_ARRAY_CPP
@@ -0,0 +1,86 @@
+#ifndef AADS_MATCH_LENGTH_H
+#define AADS_MATCH_LENGTH_H
+
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+/// \brief: Length of the common prefix of byte arrays [lhs, lhs + limit) and [rhs, rhs + limit).
+/// Compares 32 bytes at a time with AVX2, 16 with SSE2 and 8 with plain words, depending on the target.
+inline size_t MatchLength(const unsigned char* lhs, const unsigned char* rhs, size_t limit) {
+    size_t len = 0;
+#ifdef __AVX2__
+    for (; len + 32 <= limit; len += 32) {
+        __m256i equal = _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(lhs + len)),
+                                          _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rhs + len)));
+        auto mask = static_cast<uint32_t>(_mm256_movemask_epi8(equal));
+        if (mask != 0xffffffffu) return len + __builtin_ctz(~mask);
+    }
+#endif
+#ifdef __SSE2__
+    for (; len + 16 <= limit; len += 16) {
+        __m128i equal = _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(lhs + len)),
+                                       _mm_loadu_si128(reinterpret_cast<const __m128i*>(rhs + len)));
+        auto mask = static_cast<uint32_t>(_mm_movemask_epi8(equal));
+        if (mask != 0xffffu) return len + __builtin_ctz(~mask);
+    }
+#endif
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    for (; len + 8 <= limit; len += 8) {
+        uint64_t lhs_word, rhs_word;
+        std::memcpy(&lhs_word, lhs + len, sizeof(lhs_word));
+        std::memcpy(&rhs_word, rhs + len, sizeof(rhs_word));
+        if (lhs_word != rhs_word) return len + __builtin_ctzll(lhs_word ^ rhs_word) / 8;
+    }
+#endif
+    while (len < limit && lhs[len] == rhs[len]) len++;
+    return len;
+}
+
+/// \brief: True for iterators over contiguous one-byte integral elements: pointers and iterators
+/// of std::string and std::vector of char types.
+template <typename It>
+struct IsContiguousByteIterator {
+private:
+    template <typename T>
+    static constexpr bool is_byte = sizeof(T) == 1 && std::is_integral<T>::value;
+    template <typename T>
+    static constexpr bool is_container_iterator = std::is_same<It, typename T::iterator>::value ||
+                                                  std::is_same<It, typename T::const_iterator>::value;
+
+public:
+    static constexpr bool value =
+            (std::is_pointer<It>::value && is_byte<typename std::remove_cv<
+                    typename std::remove_pointer<It>::type>::type>) ||
+            is_container_iterator<std::string> ||
+            is_container_iterator<std::vector<char>> ||
+            is_container_iterator<std::vector<signed char>> ||
+            is_container_iterator<std::vector<unsigned char>>;
+};
+
+/// \brief: Length of the common prefix of [lhs, lhs + limit) and [rhs, rhs + limit).
+/// Contiguous ranges of the same byte type go to the block compare kernel, others are compared one by one.
+template <typename LhsIt, typename RhsIt>
+size_t ExtendMatch(LhsIt lhs, RhsIt rhs, size_t limit) {
+    if (limit == 0 || !(*lhs == *rhs)) return 0; // most extensions stop at once
+    if constexpr (IsContiguousByteIterator<LhsIt>::value && IsContiguousByteIterator<RhsIt>::value &&
+                  std::is_same<typename std::iterator_traits<LhsIt>::value_type,
+                               typename std::iterator_traits<RhsIt>::value_type>::value) {
+        return MatchLength(reinterpret_cast<const unsigned char*>(std::addressof(*lhs)),
+                           reinterpret_cast<const unsigned char*>(std::addressof(*rhs)), limit);
+    } else {
+        size_t len = 1;
+        while (len < limit && *(lhs + len) == *(rhs + len)) len++;
+        return len;
+    }
+}
+
+#endif //AADS_MATCH_LENGTH_H
@@ -0,0 +1,79 @@
+#ifndef AADS_PACKED_ARRAY_H
+#define AADS_PACKED_ARRAY_H
+
+#include <cstdint>
+#include <vector>
+
+/// \brief: Non-owning read-only view of a PackedArray, used by searches like ArrayView for plain arrays
+class PackedArrayView {
+public:
+    PackedArrayView() : words_(nullptr), size_(0), width_(0), mask_(0) {}
+    PackedArrayView(const uint64_t* words, size_t size, size_t width) :
+                    words_(words), size_(size), width_(width),
+                    mask_(width == 64 ? ~uint64_t(0) : (uint64_t(1) << width) - 1) {}
+
+    uint64_t operator[](size_t i) const {
+        size_t bit = i * width_, word = bit / 64, offset = bit % 64;
+        uint64_t value = words_[word] >> offset;
+        if (offset + width_ > 64) value |= words_[word + 1] << (64 - offset);
+        return value & mask_;
+    }
+    [[nodiscard]] size_t size() const { return size_; }
+    [[nodiscard]] bool empty() const { return size_ == 0; }
+
+private:
+    const uint64_t* words_;
+    size_t size_;
+    size_t width_;
+    uint64_t mask_;
+};
+
+/// \brief: Array of unsigned integers of a fixed bit width (1..64) packed into 64-bit words.
+/// An element may span two words, so N values of W bits take ceil(N * W / 64) words, e.g. 33 bits
+/// per suffix array element for 5G symbols instead of 64. Set is not thread-safe even for different
+/// elements, as they may share a word.
+class PackedArray {
+public:
+    PackedArray() : size_(0), width_(0) {}
+    // Zero values to be filled with Set
+    PackedArray(size_t size, size_t width) : words_((size * width + 63) / 64), size_(size), width_(width) {}
+
+    // Width which fits values up to maximum
+    static size_t BitsFor(uint64_t maximum) { return maximum == 0 ? 1 : 64 - __builtin_clzll(maximum); }
+    template <typename Values>
+    static PackedArray Pack(const Values& values, size_t width) {
+        PackedArray result(values.size(), width);
+        for (size_t i = 0; i < values.size(); ++i) result.Set(i, values[i]);
+        return result;
+    }
+
+    uint64_t operator[](size_t i) const { return GetView()[i]; }
+    void Set(size_t i, uint64_t value) {
+        uint64_t mask = width_ == 64 ? ~uint64_t(0) : (uint64_t(1) << width_) - 1;
+        size_t bit = i * width_, word = bit / 64, offset = bit % 64;
+        value &= mask;
+        words_[word] = (words_[word] & ~(mask << offset)) | (value << offset);
+        if (offset + width_ > 64) {
+            words_[word + 1] = (words_[word + 1] & ~(mask >> (64 - offset))) | (value >> (64 - offset));
+        }
+    }
+    // Writes values [begin, end) to out
+    template <typename T>
+    void Decode(size_t begin, size_t end, T* out) const {
+        PackedArrayView view = GetView();
+        for (size_t i = begin; i < end; ++i) out[i - begin] = view[i];
+    }
+
+    [[nodiscard]] PackedArrayView GetView() const { return PackedArrayView(words_.data(), size_, width_); }
+    [[nodiscard]] size_t size() const { return size_; }
+    [[nodiscard]] bool empty() const { return size_ == 0; }
+    [[nodiscard]] size_t Width() const { return width_; }
+    [[nodiscard]] size_t MemoryUsage() const { return words_.size() * sizeof(uint64_t); }
+
+private:
+    std::vector<uint64_t> words_;
+    size_t size_;
+    size_t width_;
+};
+
+#endif //AADS_PACKED_ARRAY_H
@@ -0,0 +1,116 @@
+#ifndef AADS_PACKED_SEQUENCE_H
+#define AADS_PACKED_SEQUENCE_H
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/// \brief: Sequence over a small alphabet (DNA) packed to BITS = 2 or 4 bits per symbol, 32 or 16 symbols
+/// in a 64-bit word. Can be used as SuffixArray container with alphabet size ALPHABET_SIZE: element i is
+/// the symbol code plus one, and a terminated sequence ends with a virtual sentinel 0 which takes no memory.
+/// CommonPrefix compares a word of symbols at a time, SuffixArray uses it for LCP and pattern search and
+/// builds its initial sort keys from SYMBOL_BITS-wide symbols (see SuffixArray::key_first_step).
+template <size_t BITS = 2>
+class PackedSequence {
+    static_assert(BITS == 2 || BITS == 4, "Symbols should take 2 or 4 bits.\n");
+
+public:
+    static constexpr size_t SYMBOL_BITS = BITS;
+    static constexpr size_t ALPHABET_SIZE = (size_t(1) << BITS) + 1;
+
+    class const_iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type        = uint32_t;
+        using difference_type   = std::ptrdiff_t;
+        using pointer           = const uint32_t*;
+        using reference         = uint32_t;
+
+        const_iterator(const PackedSequence* sequence, size_t position) : sequence_(sequence), position_(position) {}
+        uint32_t operator*() const { return (*sequence_)[position_]; }
+        const_iterator& operator++() { position_++; return *this; }
+        bool operator==(const const_iterator& other) const { return position_ == other.position_; }
+        bool operator!=(const const_iterator& other) const { return position_ != other.position_; }
+
+    private:
+        const PackedSequence* sequence_;
+        size_t position_;
+    };
+
+    // ACGT for 2 bits, IUPAC nucleotide codes and gap for 4 bits, both in ASCII order
+    static std::string DefaultAlphabet() { return BITS == 2 ? "ACGT" : "-ABCDGHKMNRSTVWY"; }
+
+    PackedSequence() : length_(0), terminated_(false) {}
+    // Code of a symbol is its index in the alphabet, lowercase letters are encoded as uppercase ones.
+    // Patterns for SuffixArray search should not be terminated.
+    explicit PackedSequence(const std::string& text, bool terminated = true,
+                            const std::string& alphabet = DefaultAlphabet());
+
+    uint32_t operator[](size_t i) const {
+        return i < length_ ? ((words_[i * BITS / 64] >> (i * BITS % 64)) & MASK) + 1 : 0;
+    }
+    [[nodiscard]] size_t size() const { return length_ + terminated_; }
+    // Number of symbols without the sentinel
+    [[nodiscard]] size_t Length() const { return length_; }
+    [[nodiscard]] const_iterator begin() const { return const_iterator(this, 0); }
+    [[nodiscard]] const_iterator end() const { return const_iterator(this, size()); }
+
+    // Length of the common prefix of symbols [i, i + limit) and other symbols [j, j + limit),
+    // sentinels are not compared
+    [[nodiscard]] size_t CommonPrefix(size_t i, const PackedSequence& other, size_t j, size_t limit) const;
+
+    [[nodiscard]] size_t MemoryUsage() const { return words_.size() * sizeof(uint64_t); }
+
+private:
+    static const uint64_t MASK = (uint64_t(1) << BITS) - 1;
+    static const size_t   WORD_SYMBOLS = 64 / BITS;
+
+    // WORD_SYMBOLS codes starting from symbol i, symbol i in the lowest bits
+    [[nodiscard]] uint64_t window(size_t i) const {
+        size_t word = i * BITS / 64, offset = i * BITS % 64;
+        uint64_t result = words_[word] >> offset;
+        if (offset != 0 && word + 1 < words_.size()) result |= words_[word + 1] << (64 - offset);
+        return result;
+    }
+
+    std::vector<uint64_t> words_;
+    size_t length_;
+    bool terminated_;
+};
+
+template <size_t BITS>
+PackedSequence<BITS>::PackedSequence(const std::string& text, bool terminated, const std::string& alphabet) :
+                                     words_((text.size() + WORD_SYMBOLS - 1) / WORD_SYMBOLS),
+                                     length_(text.size()), terminated_(terminated) {
+    if (alphabet.size() > (size_t(1) << BITS)) throw std::invalid_argument("PackedSequence: alphabet is too large");
+    int code[256];
+    std::fill(code, code + 256, -1);
+    for (size_t c = 0; c < alphabet.size(); ++c) code[static_cast<unsigned char>(alphabet[c])] = c;
+    for (size_t i = 0; i < length_; ++i) {
+        int symbol = code[std::toupper(static_cast<unsigned char>(text[i]))];
+        if (symbol == -1) throw std::invalid_argument("PackedSequence: symbol is not in the alphabet");
+        words_[i / WORD_SYMBOLS] |= uint64_t(symbol) << (i % WORD_SYMBOLS * BITS);
+    }
+}
+
+template <size_t BITS>
+size_t PackedSequence<BITS>::CommonPrefix(size_t i, const PackedSequence& other, size_t j, size_t limit) const {
+    if (i >= length_ || j >= other.length_) return 0;
+    limit = std::min({limit, length_ - i, other.length_ - j});
+    size_t len = 0;
+    for (; len + WORD_SYMBOLS <= limit; len += WORD_SYMBOLS) {
+        uint64_t difference = window(i + len) ^ other.window(j + len);
+        if (difference != 0) return len + __builtin_ctzll(difference) / BITS;
+    }
+    if (len < limit) {
+        uint64_t difference = (window(i + len) ^ other.window(j + len)) & ((uint64_t(1) << (limit - len) * BITS) - 1);
+        if (difference != 0) return len + __builtin_ctzll(difference) / BITS;
+    }
+    return limit;
+}
+
+#endif //AADS_PACKED_SEQUENCE_H
@@ -1,7 +1,13 @@
+#ifndef AADS_PREF_FUNC_CPP
+#define AADS_PREF_FUNC_CPP
+
+#include <algorithm>
 #include <iostream>
 #include <vector>
 #include <string>
 
+#include "MatchLength.h"
+
 template <typename It, typename T = uint32_t>
 std::vector<T> CalculatePrefixFunc(It begin, It end) {
     static_assert(
@@ -20,6 +26,101 @@ std::vector<T> CalculatePrefixFunc(It begin, It end) {
         if (*(begin + result[ind]) == *i) {
             result[ind]++;
         }
+        // While the next symbols continue the border, prefix function grows by one at each of them
+        if (result[ind] > 0) {
+            size_t run = ExtendMatch(std::next(i), begin + result[ind], std::distance(std::next(i), end));
+            for (size_t j = 1; j <= run; ++j) {
+                result[ind + j] = result[ind] + j;
+            }
+            i += run;
+        }
     }
     return result;
 }
+
+
+/// \brief: KMP matcher with a full DFA of (pattern length + 1) x alphabet transitions built from
+/// the prefix function. Every text symbol costs one table lookup in the worst case (no fallback loop),
+/// the text is processed in chunks as a stream and is never copied or concatenated with the pattern.
+/// Symbols should be integral, their unsigned values should be less than alphabet_size.
+template <typename T = uint32_t>
+class KMPAutomaton {
+public:
+    template <typename It>
+    KMPAutomaton(It begin, It end, size_t alphabet_size = 256);
+
+    // Feeds [begin, end) as the next chunk. callback(offset) is called for every occurrence with
+    // the offset of its start from the beginning of the stream, it may start in previous chunks.
+    template <typename It, typename Callback>
+    void Feed(It begin, It end, Callback callback);
+    void Reset() {
+        state_ = 0;
+        processed_ = 0;
+    }
+
+private:
+    template <typename Symbol>
+    static size_t symbol_index(Symbol symbol) {
+        return static_cast<typename std::make_unsigned<Symbol>::type>(symbol);
+    }
+
+    const size_t ALPHABET_SIZE;
+    size_t pattern_size_;
+    std::vector<T> transitions_; // transitions_[state * ALPHABET_SIZE + symbol]
+    T state_;
+    uint64_t processed_;
+};
+
+template <typename T>
+template <typename It>
+KMPAutomaton<T>::KMPAutomaton(It begin, It end, size_t alphabet_size) : ALPHABET_SIZE(alphabet_size),
+                                                                         pattern_size_(std::distance(begin, end)),
+                                                                         transitions_((pattern_size_ + 1) * alphabet_size),
+                                                                         state_(0), processed_(0) {
+    if (pattern_size_ == 0) return;
+    std::vector<T> prefix = CalculatePrefixFunc<It, T>(begin, end);
+    transitions_[symbol_index(*begin)] = 1;
+    for (size_t state = 1; state <= pattern_size_; ++state) {
+        // Mismatch goes the same way as from the longest proper border of the matched prefix
+        std::copy_n(transitions_.begin() + prefix[state - 1] * ALPHABET_SIZE, ALPHABET_SIZE,
+                    transitions_.begin() + state * ALPHABET_SIZE);
+        if (state < pattern_size_) transitions_[state * ALPHABET_SIZE + symbol_index(*(begin + state))] = state + 1;
+    }
+}
+
+template <typename T>
+template <typename It, typename Callback>
+void KMPAutomaton<T>::Feed(It begin, It end, Callback callback) {
+    if (pattern_size_ == 0) return;
+    const T* transitions = transitions_.data();
+    uint64_t offset = processed_;
+    for (It it = begin; it != end; ++it, ++offset) {
+        state_ = transitions[state_ * ALPHABET_SIZE + symbol_index(*it)];
+        if (state_ == pattern_size_) callback(offset + 1 - pattern_size_);
+    }
+    processed_ = offset;
+}
+
+
+/// \brief: Finds occurrences of pattern [pattern_begin, pattern_end) in text [text_begin, text_end)
+/// without building "pattern#text". Prefix function is calculated for the pattern only and the text
+/// is read once from left to right, so extra memory is O(|pattern|) and any input iterator fits the text.
+/// callback(position) is called for every occurrence in increasing order of positions.
+template <typename PatternIt, typename TextIt, typename Callback, typename T = uint32_t>
+void SearchWithPrefixFunc(PatternIt pattern_begin, PatternIt pattern_end, TextIt text_begin, TextIt text_end,
+                          Callback callback) {
+    size_t pattern_len = std::distance(pattern_begin, pattern_end);
+    if (pattern_len == 0) return;
+    std::vector<T> prefix = CalculatePrefixFunc<PatternIt, T>(pattern_begin, pattern_end);
+
+    size_t matched = 0, position = 0;
+    for (auto it = text_begin; it != text_end; ++it, ++position) {
+        while (matched > 0 && (matched == pattern_len || *(pattern_begin + matched) != *it)) {
+            matched = prefix[matched - 1];
+        }
+        if (*(pattern_begin + matched) == *it) matched++;
+        if (matched == pattern_len) callback(position + 1 - pattern_len);
+    }
+}
+
+#endif //AADS_PREF_FUNC_CPP
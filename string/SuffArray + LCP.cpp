@@ -1,45 +1,594 @@
+#ifndef AADS_SUFFARRAY_LCP_CPP
+#define AADS_SUFFARRAY_LCP_CPP
+
+#include <algorithm>
+#include <deque>
 #include <iostream>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
+#include "BitVector.h"
+#include "CompressedLCP.h"
+#include "PackedArray.h"
+
+/// \brief: Non-owning read-only view of a contiguous array
+template <typename T>
+class ArrayView {
+public:
+    ArrayView() : data_(nullptr), size_(0) {}
+    ArrayView(const T* data, size_t size) : data_(data), size_(size) {}
+
+    const T& operator[](size_t i) const { return data_[i]; }
+    [[nodiscard]] const T* data() const { return data_; }
+    [[nodiscard]] size_t size() const { return size_; }
+    [[nodiscard]] bool empty() const { return size_ == 0; }
+    [[nodiscard]] const T* begin() const { return data_; }
+    [[nodiscard]] const T* end() const { return data_ + size_; }
+
+private:
+    const T* data_;
+    size_t size_;
+};
+
+/// \brief: Symbol as an unsigned integer. Suffixes are ordered by unsigned symbols, so bytes >= 0x80 of char
+/// strings go after ASCII ones and after the sentinel '\0', and symbols can index counting arrays.
+template <typename Symbol>
+typename std::make_unsigned<Symbol>::type UnsignedSymbol(Symbol symbol) {
+    return static_cast<typename std::make_unsigned<Symbol>::type>(symbol);
+}
+
+/// \brief: Range minimum queries in O(1) with o(N) extra memory. Values are not copied, they are
+/// passed to every call, so the structure stays valid when the owner of values is moved.
+/// Elements are grouped into blocks of BLOCK, blocks into superblocks of BLOCK blocks. A query scans
+/// at most two partial blocks and two partial superblocks, whole superblocks are covered by a sparse table.
+template <typename T>
+class RangeMinimum {
+public:
+    RangeMinimum() = default;
+    template <typename Values>
+    explicit RangeMinimum(const Values& values);
+
+    // Index of the leftmost minimum in [left, right]
+    template <typename Values>
+    [[nodiscard]] size_t Query(const Values& values, size_t left, size_t right) const;
+    [[nodiscard]] bool Empty() const { return block_min_.empty(); }
+
+private:
+    static const size_t BLOCK = 32;
+
+    // Index of the leftmost minimum in [left, right)
+    template <typename Values>
+    static size_t scan(const Values& values, size_t left, size_t right);
+    template <typename Values>
+    static size_t pick(const Values& values, size_t lhs, size_t rhs) { return values[rhs] < values[lhs] ? rhs : lhs; }
+    // Block with the leftmost minimum among blocks [left, right)
+    size_t min_block(size_t left, size_t right) const;
+
+    size_t size_ = 0;
+    std::vector<T> block_min_;
+    std::vector<std::vector<uint32_t>> sparse_; // sparse_[k][s] - block with minimum in superblocks [s, s + 2^k)
+};
+
+template <typename T>
+template <typename Values>
+RangeMinimum<T>::RangeMinimum(const Values& values) : size_(values.size()) {
+    size_t blocks = (size_ + BLOCK - 1) / BLOCK;
+    block_min_.resize(blocks);
+    for (size_t block = 0; block < blocks; ++block) {
+        block_min_[block] = values[scan(values, block * BLOCK, std::min(size_, (block + 1) * BLOCK))];
+    }
+    size_t superblocks = (blocks + BLOCK - 1) / BLOCK;
+    if (superblocks == 0) return;
+    sparse_.emplace_back(superblocks);
+    for (size_t superblock = 0; superblock < superblocks; ++superblock) {
+        sparse_[0][superblock] = scan(block_min_, superblock * BLOCK, std::min(blocks, (superblock + 1) * BLOCK));
+    }
+    for (size_t k = 1; (size_t(1) << k) <= superblocks; ++k) {
+        size_t half = size_t(1) << (k - 1);
+        sparse_.emplace_back(superblocks - 2 * half + 1);
+        for (size_t i = 0; i < sparse_[k].size(); ++i) {
+            sparse_[k][i] = pick(block_min_, sparse_[k - 1][i], sparse_[k - 1][i + half]);
+        }
+    }
+}
+
+template <typename T>
+template <typename Values>
+size_t RangeMinimum<T>::scan(const Values& values, size_t left, size_t right) {
+    size_t best = left;
+    for (size_t i = left + 1; i < right; ++i) {
+        if (values[i] < values[best]) best = i;
+    }
+    return best;
+}
+
+template <typename T>
+size_t RangeMinimum<T>::min_block(size_t left, size_t right) const {
+    if (right - left <= 2 * BLOCK) return scan(block_min_, left, right);
+    size_t first_full = (left + BLOCK - 1) / BLOCK, last_full = right / BLOCK;
+    size_t k = 63 - __builtin_clzll(last_full - first_full);
+    size_t best = pick(block_min_, sparse_[k][first_full], sparse_[k][last_full - (size_t(1) << k)]);
+    if (left < first_full * BLOCK) best = pick(block_min_, scan(block_min_, left, first_full * BLOCK), best);
+    if (last_full * BLOCK < right) best = pick(block_min_, best, scan(block_min_, last_full * BLOCK, right));
+    return best;
+}
+
+template <typename T>
+template <typename Values>
+size_t RangeMinimum<T>::Query(const Values& values, size_t left, size_t right) const {
+    right++;
+    if (right - left <= 2 * BLOCK) return scan(values, left, right);
+    size_t first_full = (left + BLOCK - 1) / BLOCK, last_full = right / BLOCK;
+    size_t block = min_block(first_full, last_full);
+    size_t best = scan(values, block * BLOCK, std::min(size_, (block + 1) * BLOCK));
+    if (left < first_full * BLOCK) best = pick(values, scan(values, left, first_full * BLOCK), best);
+    if (last_full * BLOCK < right) best = pick(values, best, scan(values, last_full * BLOCK, right));
+    return best;
+}
+
+/// \brief: Algorithm used to sort suffixes.
+enum class SuffixArrayAlgorithm {
+    PrefixDoubling, // O(N log N), sorts cyclic shifts of length 2^k
+    InducedSorting  // O(N), SA-IS by Nong, Zhang and Chan
+};
+
+/// \brief: Algorithm used to compute LCP array.
+/// Peak memory is given for a byte text and 32-bit index.
+enum class LCPAlgorithm {
+    Kasai, // walks suffixes in text order using the inverse suffix array, 13 bytes per symbol
+    Phi    // permuted LCP (Karkkainen, Manzini, Puglisi) from Phi array which takes place of the inverse
+           // suffix array, then permuted to LCP in place: 9 bytes and 1 bit per symbol, multi-threaded
+};
+
+/// \brief: Representation of LCP array kept by SuffixArray.
+enum class LCPStorage {
+    Plain,      // Index per value, available as a view
+    Compressed, // byte per value with overflow table (see CompressedLCP.h), O(1) access
+    Packed      // ceil(log2 N) bits per value (see PackedArray.h), O(1) access
+};
+
+/// \brief: Alphabet size which makes SuffixArray rank-compact the symbols before sorting: distinct symbols
+/// are replaced by their ranks, so any integer symbols (e.g. 32-bit token ids) are sorted with memory
+/// proportional to the text instead of the largest symbol.
+const size_t COMPACT_ALPHABET = 0;
+
+/// \brief: Optional container primitives used by SuffixArray (see PackedSequence.h):
+/// CommonPrefix(i, other, j, limit) - length of the common prefix of two runs of symbols, computed a word at a time,
+/// SYMBOL_BITS - symbols are less than 2^SYMBOL_BITS + 1, so the first sort can use k-mer keys of 64 bits.
+template <typename Container, typename = void>
+struct HasCommonPrefix : std::false_type {};
+template <typename Container>
+struct HasCommonPrefix<Container, std::void_t<decltype(std::declval<const Container&>().CommonPrefix(
+        size_t(), std::declval<const Container&>(), size_t(), size_t()))>> : std::true_type {};
+
+template <typename Container, typename = void>
+struct HasSymbolBits : std::false_type {};
+template <typename Container>
+struct HasSymbolBits<Container, std::void_t<decltype(Container::SYMBOL_BITS)>> : std::true_type {};
+
+/// \brief: Pattern search in a suffix array given by views of the text and of the array, so it works the same
+/// over arrays of SuffixArray and over arrays mapped from a file (see SuffixArrayFile.cpp). The text is referenced.
+/// Occurrences of the pattern (without sentinel) form a range of the suffix array. Searches are O(m log n),
+/// or O(m + log n) if LCP-LR arrays are given. The suffix array is an ArrayView or a PackedArrayView.
+template <typename Text, typename Index, typename Array = ArrayView<Index>>
+class SuffixArraySearch {
+public:
+    SuffixArraySearch(const Text& text, Array array, ArrayView<Index> lcp_left = ArrayView<Index>(),
+                      ArrayView<Index> lcp_right = ArrayView<Index>()) : text_(text), array_(array),
+                                                                         lcp_left_(lcp_left), lcp_right_(lcp_right) {}
+
+    template <typename Pattern>
+    [[nodiscard]] std::pair<size_t, size_t> Range(const Pattern& pattern) const;
+    // Ranges for a batch of patterns. Patterns are processed in sorted order and equal patterns are searched once.
+    // With LCP-LR arrays every pattern is searched by them. Otherwise search for the next pattern gallops from the
+    // range of the previous one: within that range if the previous pattern is a prefix of the next one (and then
+    // the prefix is not compared again), after it if not.
+    template <typename Pattern>
+    [[nodiscard]] std::vector<std::pair<size_t, size_t>> RangeBatch(const std::vector<Pattern>& patterns) const;
+
+private:
+    // match returns the length of common prefix of the pattern and the suffix, first `skip` symbols are
+    // known to be equal. goes_right tells if the suffix with given common prefix is on the left of the searched bound.
+    template <typename Pattern>
+    size_t match(const Pattern& pattern, size_t suffix, size_t skip) const;
+    template <typename Pattern>
+    bool goes_right(const Pattern& pattern, size_t suffix, size_t common, bool upper) const;
+    // Binary search in [first, last) comparing from min(l, r) symbol (mlr heuristic), O(m log n) worst case.
+    // Every suffix in [first, last) must share at least min(l, r) first symbols with the pattern.
+    template <typename Pattern>
+    size_t bound(const Pattern& pattern, bool upper, size_t first, size_t last, size_t l = 0, size_t r = 0) const;
+    // Exponential search from `first` followed by the binary search, every suffix in [first, last) shares `skip`
+    // first symbols with the pattern
+    template <typename Pattern>
+    size_t gallop(const Pattern& pattern, bool upper, size_t first, size_t last, size_t skip) const;
+    // Binary search over the whole array using LCP-LR (Manber, Myers), O(m + log n)
+    template <typename Pattern>
+    size_t bound_lcp_lr(const Pattern& pattern, bool upper) const;
+
+    const Text& text_;
+    Array array_;
+    // For every middle of binary search interval (left, right): LCP of suffixes left and middle,
+    // and of suffixes middle and right. Right end of the whole interval is a virtual +infinity suffix.
+    ArrayView<Index> lcp_left_;
+    ArrayView<Index> lcp_right_;
+};
+
+template<typename Text, typename Index, typename Array>
+template<typename Pattern>
+size_t SuffixArraySearch<Text, Index, Array>::match(const Pattern& pattern, size_t suffix, size_t skip) const {
+    size_t common = skip;
+    if constexpr (HasCommonPrefix<Text>::value && std::is_same<Pattern, Text>::value) {
+        return common + text_.CommonPrefix(suffix + common, pattern, common, pattern.size() - common);
+    }
+    while (common < pattern.size() && suffix + common < text_.size() &&
+           text_[suffix + common] == pattern[common]) {
+        common++;
+    }
+    return common;
+}
+
+template<typename Text, typename Index, typename Array>
+template<typename Pattern>
+bool SuffixArraySearch<Text, Index, Array>::goes_right(const Pattern& pattern, size_t suffix, size_t common,
+                                                       bool upper) const {
+    if (common == pattern.size()) return upper;
+    return suffix + common == text_.size() ||
+           UnsignedSymbol(text_[suffix + common]) < UnsignedSymbol(pattern[common]);
+}
+
+template<typename Text, typename Index, typename Array>
+template<typename Pattern>
+size_t SuffixArraySearch<Text, Index, Array>::bound(const Pattern& pattern, bool upper, size_t first, size_t last,
+                                                    size_t l, size_t r) const {
+    // l and r are common prefixes with suffixes first - 1 and last
+    size_t count = last - first;
+    while (count > 0) {
+        size_t step = count / 2;
+        size_t middle = first + step;
+        size_t common = match(pattern, array_[middle], std::min(l, r));
+        if (goes_right(pattern, array_[middle], common, upper)) {
+            first = middle + 1;
+            count -= step + 1;
+            l = common;
+        } else {
+            count = step;
+            r = common;
+        }
+    }
+    return first;
+}
+
+template<typename Text, typename Index, typename Array>
+template<typename Pattern>
+size_t SuffixArraySearch<Text, Index, Array>::gallop(const Pattern& pattern, bool upper, size_t first, size_t last,
+                                                     size_t skip) const {
+    size_t l = skip, r = skip;
+    size_t probe = first, step = 1;
+    while (probe < last) {
+        size_t common = match(pattern, array_[probe], skip);
+        if (!goes_right(pattern, array_[probe], common, upper)) {
+            r = common;
+            break;
+        }
+        l = common;
+        first = probe + 1;
+        probe = first + step;
+        step *= 2;
+    }
+    return bound(pattern, upper, first, std::min(probe, last), l, r);
+}
+
+template<typename Text, typename Index, typename Array>
+template<typename Pattern>
+size_t SuffixArraySearch<Text, Index, Array>::bound_lcp_lr(const Pattern& pattern, bool upper) const {
+    // Suffix 0 is the sentinel, which is less than any non-empty pattern
+    size_t left = 0, right = array_.size();
+    size_t l = 0, r = 0;
+    while (right - left > 1) {
+        size_t middle = (left + right) / 2;
+        size_t common;
+        // If the pattern shares more with one end, LCP of that end and the middle decides without comparing
+        if (l >= r) {
+            if (lcp_left_[middle] > l) {
+                left = middle;
+                continue;
+            }
+            if (lcp_left_[middle] < l) {
+                right = middle;
+                r = lcp_left_[middle];
+                continue;
+            }
+            common = match(pattern, array_[middle], l);
+        } else {
+            if (lcp_right_[middle] > r) {
+                right = middle;
+                continue;
+            }
+            if (lcp_right_[middle] < r) {
+                left = middle;
+                l = lcp_right_[middle];
+                continue;
+            }
+            common = match(pattern, array_[middle], r);
+        }
+        if (goes_right(pattern, array_[middle], common, upper)) {
+            left = middle;
+            l = common;
+        } else {
+            right = middle;
+            r = common;
+        }
+    }
+    return right;
+}
+
+template<typename Text, typename Index, typename Array>
+template<typename Pattern>
+std::pair<size_t, size_t> SuffixArraySearch<Text, Index, Array>::Range(const Pattern& pattern) const {
+    if (pattern.size() == 0) return {0, array_.size()};
+    if (lcp_left_.empty()) {
+        size_t lower = bound(pattern, false, 0, array_.size());
+        return {lower, bound(pattern, true, lower, array_.size())};
+    }
+    return {bound_lcp_lr(pattern, false), bound_lcp_lr(pattern, true)};
+}
+
+template<typename Text, typename Index, typename Array>
+template<typename Pattern>
+std::vector<std::pair<size_t, size_t>> SuffixArraySearch<Text, Index, Array>::RangeBatch(const std::vector<Pattern>& patterns) const {
+    std::vector<size_t> order(patterns.size());
+    for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+    auto common_prefix = [&patterns](size_t lhs, size_t rhs) {
+        const auto& a = patterns[lhs];
+        const auto& b = patterns[rhs];
+        size_t i = 0;
+        while (i < a.size() && i < b.size() && a[i] == b[i]) ++i;
+        return i;
+    };
+    auto less = [&patterns, &common_prefix](size_t lhs, size_t rhs) {
+        const auto& a = patterns[lhs];
+        const auto& b = patterns[rhs];
+        size_t i = common_prefix(lhs, rhs);
+        return i < b.size() && (i == a.size() || UnsignedSymbol(a[i]) < UnsignedSymbol(b[i]));
+    };
+    std::sort(order.begin(), order.end(), less);
+
+    std::vector<std::pair<size_t, size_t>> result(patterns.size());
+    size_t size = array_.size();
+    size_t lower = 0, upper = size; // range of the previous pattern
+    for (size_t i = 0; i < order.size(); ++i) {
+        const auto& pattern = patterns[order[i]];
+        if (i > 0 && !less(order[i - 1], order[i])) {
+            result[order[i]] = result[order[i - 1]];
+            continue;
+        }
+        if (i == 0 || !lcp_left_.empty()) {
+            std::tie(lower, upper) = result[order[i]] = Range(pattern);
+            continue;
+        }
+        size_t common = common_prefix(order[i - 1], order[i]);
+        if (common == patterns[order[i - 1]].size()) {
+            // The previous pattern is a prefix: the range is inside the previous one, all of which shares it
+            lower = gallop(pattern, false, lower, upper, common);
+            upper = gallop(pattern, true, lower, upper, common);
+        } else {
+            // The pattern is greater than every string which starts with the previous pattern
+            lower = gallop(pattern, false, upper, size, 0);
+            upper = gallop(pattern, true, lower, size, 0);
+        }
+        result[order[i]] = {lower, upper};
+    }
+    return result;
+}
+
+/// \brief: Scratch buffers of suffix array construction. Pass the same workspace to many builds
+/// (constructor or Rebuild) to keep the buffers between them: once a string of the largest size has been
+/// built, single-threaded rebuilds do no heap allocations. A workspace can be used by one build at a time.
+template <typename Index = uint32_t>
+class SuffixArrayWorkspace {
+private:
+    template <typename C, typename I>
+    friend class SuffixArray;
+
+    // Buffers of one SA-IS recursion level
+    struct InducedLevel {
+        std::vector<bool>  is_s;
+        std::vector<Index> bucket_begin;
+        std::vector<Index> bucket;
+        std::vector<Index> lms;
+        std::vector<Index> name;
+        std::vector<Index> reduced;
+        std::vector<Index> reduced_sa;
+    };
+
+    std::vector<Index>        count_;
+    std::vector<Index>        permutation_;
+    std::vector<Index>        color_;
+    std::vector<Index>        ranks_; // compacted symbols
+    std::vector<uint64_t>     keys_;  // k-mer keys of packed containers
+    std::deque<InducedLevel>  levels_; // deque keeps references to upper levels valid while recursing
+};
+
 /// \brief: Builds suffix array on given string ending with a sentinel
 /// (such symbol that sentinel < container is always true)
-template <typename Container>
+/// Index is the type of suffix array and LCP elements, the string should be shorter than its maximum value.
+template <typename Container, typename Index = uint32_t>
 class SuffixArray {
 private:
+    // Builds arrays for container_ with buffers of the workspace, or of a temporary one if workspace_ is null
+    void build();
+    void build(SuffixArrayWorkspace<Index>& workspace);
+    // Sorts suffixes of s, which is container_ or its compacted copy, symbols of s are in [0, alphabet_size)
+    template <typename Symbols>
+    void sort_suffixes(const Symbols& s, size_t alphabet_size, SuffixArrayWorkspace<Index>& workspace);
+    // Replaces symbols of container_ by their ranks among distinct symbols (workspace.ranks_), returns the
+    // number of them. Every thread sorts and deduplicates positions of its chunk by symbol, then the chunks
+    // are merged and symbols are ranked by binary search. Distinct symbols are represented by positions,
+    // so all buffers are index arrays: permutation_ and the workspace ones.
+    size_t compact_alphabet(SuffixArrayWorkspace<Index>& workspace);
+
     // Building consists of log N phases. On k-th step we sort cyclic shifts of length 2^k.
-    uint32_t first_step();
-    uint32_t next_step(size_t k);
+    template <typename Symbols>
+    Index first_step(const Symbols& s, size_t alphabet_size, SuffixArrayWorkspace<Index>& workspace);
+    Index next_step(size_t k, SuffixArrayWorkspace<Index>& workspace);
+    // First step for containers with SYMBOL_BITS: sorts cyclic shifts of length k = 64 / (SYMBOL_BITS + 1)
+    // at once by LSD radix sort of their k-mers packed to 64-bit keys, sets k.
+    Index key_first_step(size_t& k, SuffixArrayWorkspace<Index>& workspace);
+
+    // Parallel versions of the phases. Counting sorts become stable LSD radix sorts with per-thread
+    // histograms, recolouring counts class boundaries in every chunk and then assigns colors.
+    template <typename Symbols>
+    Index parallel_first_step(const Symbols& s, size_t alphabet_size, SuffixArrayWorkspace<Index>& workspace);
+    Index parallel_next_step(size_t k, Index colors, SuffixArrayWorkspace<Index>& workspace);
+    // Stable sort of permutation_ by key(position) < keys, 16 bits of the key per pass, so histograms take
+    // THREADS * min(keys, 2^16) counters for any number of keys.
+    template <typename Key>
+    void parallel_radix_sort(Key key, size_t keys, SuffixArrayWorkspace<Index>& workspace);
+    template <typename Differs>
+    Index parallel_recolor(Differs differs, std::vector<Index>& new_color) const;
+    // Splits [0, size) into THREADS chunks and calls function(chunk, begin, end) for each in its own thread.
+    template <typename Function>
+    void parallel_for(size_t size, Function function) const;
+
+    // SA-IS: sorts LMS substrings by induction, names them and recurses on the reduced string
+    // if names are not unique. Then the order of all suffixes is induced from sorted LMS suffixes.
+    template <typename Symbols>
+    static void induced_sort(const Symbols& s, size_t alphabet_size, std::vector<Index>& sa,
+                             SuffixArrayWorkspace<Index>& workspace, size_t depth = 0);
+
+    // LCP construction. Phi mode uses color_ as the Phi and PLCP array and leaves it empty,
+    // restore_inverse makes it the inverse suffix array again when needed.
+    // common_prefix returns the length of common prefix of suffixes i and j, first `skip` symbols are equal.
+    // Kasai's algorithm passes every value to store(position, value).
+    template <typename Store>
+    void build_lcp_kasai(Store store);
+    void build_lcp_phi();
+    void restore_inverse();
+    size_t common_prefix(size_t i, size_t j, size_t skip) const;
+    // Suffix array value from the plain or packed array
+    Index array_at(size_t i) const { return packed_array_.empty() ? permutation_[i] : packed_array_[i]; }
+    // LCP value from the plain, compressed or packed array
+    Index lcp_at(size_t i) const {
+        if (!compressed_lcp_.empty()) return compressed_lcp_[i];
+        return packed_lcp_.empty() ? lcp_[i] : packed_lcp_[i];
+    }
+    // Bits per value of packed arrays: values are less than the length
+    size_t packed_width() const { return PackedArray::BitsFor(container_.size() - 1); }
+
+    // Pattern search over the given view of the suffix array, with LCP-LR if it is built
+    template <typename Array>
+    SuffixArraySearch<Container, Index, Array> search(Array array) const {
+        return SuffixArraySearch<Container, Index, Array>(container_, array,
+                                                          ArrayView<Index>(lcp_left_.data(), lcp_left_.size()),
+                                                          ArrayView<Index>(lcp_right_.data(), lcp_right_.size()));
+    }
+    Index build_lcp_lr(size_t left, size_t right);
 
     Container container_;
-    std::vector<uint32_t> color_;
-    std::vector<uint32_t> permutation_;
-    std::vector<uint32_t> lcp_;
+    std::vector<Index> color_;
+    std::vector<Index> permutation_;
+    PackedArray packed_array_; // non-empty instead of permutation_ after Pack
+    std::vector<Index> lcp_;
+    CompressedLCP<Index> compressed_lcp_; // non-empty instead of lcp_ for compressed storage
+    PackedArray packed_lcp_; // non-empty instead of lcp_ for packed storage
+    std::vector<Index> lcp_left_; // LCP-LR arrays (see SuffixArraySearch)
+    std::vector<Index> lcp_right_;
+    RangeMinimum<Index> lcp_rmq_;
     const size_t ALPHABET_SIZE;
+    const size_t THREADS;
+    const SuffixArrayAlgorithm ALGORITHM;
+    SuffixArrayWorkspace<Index>* workspace_;
 
 public:
-    explicit SuffixArray(Container  input, size_t alphabet_size = 256);
-    void BuildLCP();
-    [[nodiscard]] std::vector<uint32_t> GetLCP() const { return lcp_; }
-    [[nodiscard]] std::vector<uint32_t> GetArray() const { return permutation_; }
+    // Symbols should be in [0, alphabet_size), or any integers if alphabet_size is COMPACT_ALPHABET.
+    // threads > 1 parallelizes prefix doubling and compaction, SA-IS is always built in a single thread.
+    // Workspace is borrowed for the construction and all rebuilds, it should outlive the suffix array.
+    explicit SuffixArray(Container  input, size_t alphabet_size = 256,
+                         SuffixArrayAlgorithm algorithm = SuffixArrayAlgorithm::PrefixDoubling,
+                         size_t threads = 1, SuffixArrayWorkspace<Index>* workspace = nullptr);
+    // Builds the array for another string with the same parameters reusing the memory of this object
+    // and of the workspace. LCP and search structures should be built again, and the array packed again.
+    void Rebuild(const Container& input);
+    // Phi mode runs in threads given to the constructor. LCP is empty until it is built.
+    // Compressed storage takes about 1.15 bytes per value instead of sizeof(Index), packed storage takes
+    // ceil(log2 N) bits. Kasai's algorithm writes them directly, Phi builds the plain array first.
+    // LCP RMQ, if it was built, is built again.
+    void BuildLCP(LCPAlgorithm algorithm = LCPAlgorithm::Kasai, LCPStorage storage = LCPStorage::Plain);
+    // Moves the suffix array, and the plain LCP if it is built, to packed arrays of ceil(log2 N) bits per value,
+    // e.g. 33 bits for 5G symbols with 64-bit Index. The inverse array is released unless LCP RMQ needs it.
+    // Search, Locate, Lcp and LCP construction read the packed array in place. Array view is empty then,
+    // use GetPackedArray; EnhancedSuffixArray and FMIndex need the plain array.
+    void Pack();
+    [[nodiscard]] const Container& GetText() const { return container_; }
+    [[nodiscard]] std::vector<Index> GetLCP() const;
+    [[nodiscard]] std::vector<Index> GetArray() const;
+    // Views of the results without copying, valid until the next Rebuild or destruction.
+    // LCP view is empty for compressed and packed storage, use GetCompressedLCP or GetPackedLCP then.
+    [[nodiscard]] ArrayView<Index> GetLCPView() const { return ArrayView<Index>(lcp_.data(), lcp_.size()); }
+    [[nodiscard]] const CompressedLCP<Index>& GetCompressedLCP() const { return compressed_lcp_; }
+    [[nodiscard]] const PackedArray& GetPackedLCP() const { return packed_lcp_; }
+    [[nodiscard]] ArrayView<Index> GetArrayView() const {
+        return ArrayView<Index>(permutation_.data(), permutation_.size());
+    }
+    // Empty until Pack
+    [[nodiscard]] const PackedArray& GetPackedArray() const { return packed_array_; }
+
+    // LCP of suffixes starting at arbitrary positions i and j in O(1). Call BuildLCP and then BuildLCPRMQ.
+    void BuildLCPRMQ() {
+        restore_inverse();
+        if (!compressed_lcp_.empty()) {
+            lcp_rmq_ = RangeMinimum<Index>(compressed_lcp_);
+        } else {
+            lcp_rmq_ = packed_lcp_.empty() ? RangeMinimum<Index>(lcp_) : RangeMinimum<Index>(packed_lcp_);
+        }
+    }
+    [[nodiscard]] Index Lcp(size_t i, size_t j) const;
+
+    // Occurrences of the pattern (without sentinel) form a range of the suffix array.
+    // Call BuildLCP and then BuildLCPLR to get O(m + log n) searches, otherwise they are O(m log n).
+    void BuildLCPLR();
+    template <typename Pattern>
+    [[nodiscard]] std::pair<size_t, size_t> Range(const Pattern& pattern) const;
+    template <typename Pattern>
+    [[nodiscard]] size_t Count(const Pattern& pattern) const;
+    // Positions of occurrences in suffix array order
+    template <typename Pattern>
+    [[nodiscard]] std::vector<Index> Locate(const Pattern& pattern) const;
+    // Ranges for a batch of patterns, see SuffixArraySearch::RangeBatch
+    template <typename Pattern>
+    [[nodiscard]] std::vector<std::pair<size_t, size_t>> RangeBatch(const std::vector<Pattern>& patterns) const;
+
+    // Writes text, suffix array and LCP to an index file (see SuffixArrayFile.cpp)
+    template <typename C, typename I>
+    friend void SaveSuffixArray(const SuffixArray<C, I>& suffix_array, const std::string& path);
 };
 
-template<typename Container>
-uint32_t SuffixArray<Container>::first_step() {
-    std::vector<int32_t> count(ALPHABET_SIZE);
-    for (const auto& item : container_) count[item]++;
+template<typename Container, typename Index>
+template<typename Symbols>
+Index SuffixArray<Container, Index>::first_step(const Symbols& s, size_t alphabet_size,
+                                                SuffixArrayWorkspace<Index>& workspace) {
+    auto& count = workspace.count_;
+    count.assign(alphabet_size, 0);
+    for (const auto& item : s) count[UnsignedSymbol(item)]++;
 
-    for (size_t i = 1; i < ALPHABET_SIZE; ++i)
+    for (size_t i = 1; i < alphabet_size; ++i)
         count[i] += count[i - 1];
 
-    ssize_t size = container_.size();
+    ssize_t size = s.size();
     for (ssize_t i = size - 1; i >= 0; --i) {
-        permutation_[--count[container_[i]]] = i;
+        permutation_[--count[UnsignedSymbol(s[i])]] = i;
     }
 
     for (size_t i = 1; i < size; ++i) {
         color_[permutation_[i]] = color_[permutation_[i - 1]];
-        if (container_[permutation_[i]] != container_[permutation_[i - 1]]) {
+        if (s[permutation_[i]] != s[permutation_[i - 1]]) {
             color_[permutation_[i]]++;
         }
     }
@@ -47,26 +596,169 @@ uint32_t SuffixArray<Container>::first_step() {
 }
 
 
-template<typename Container>
-SuffixArray<Container>::SuffixArray(Container input, size_t alphabet_size) :
-                                    ALPHABET_SIZE(alphabet_size),
+template<typename Container, typename Index>
+SuffixArray<Container, Index>::SuffixArray(Container input, size_t alphabet_size, SuffixArrayAlgorithm algorithm,
+                                    size_t threads, SuffixArrayWorkspace<Index>* workspace) :
                                     container_(std::move(input)),
-                                    color_(container_.size()),
-                                    permutation_(container_.size()),
-                                    lcp_(container_.size()) {
-    uint32_t different_colors = first_step();
-    for (size_t k = 1; k < container_.size(); k <<= 1) {
-        if (different_colors == container_.size()) break;
-        different_colors = next_step(k);
+                                    ALPHABET_SIZE(alphabet_size),
+                                    THREADS(std::max<size_t>(threads, 1)),
+                                    ALGORITHM(algorithm),
+                                    workspace_(workspace) {
+    build();
+}
+
+template<typename Container, typename Index>
+void SuffixArray<Container, Index>::Rebuild(const Container& input) {
+    container_ = input;
+    build();
+}
+
+template<typename Container, typename Index>
+void SuffixArray<Container, Index>::build() {
+    if (workspace_ != nullptr) {
+        build(*workspace_);
+    } else {
+        SuffixArrayWorkspace<Index> workspace;
+        build(workspace);
+    }
+}
+
+template<typename Container, typename Index>
+void SuffixArray<Container, Index>::build(SuffixArrayWorkspace<Index>& workspace) {
+    if (container_.size() >= std::numeric_limits<Index>::max()) {
+        throw std::length_error("SuffixArray: string is too long for the index type");
+    }
+    color_.assign(container_.size(), 0);
+    permutation_.resize(container_.size());
+    packed_array_ = PackedArray();
+    lcp_.clear();
+    compressed_lcp_ = CompressedLCP<Index>();
+    packed_lcp_ = PackedArray();
+    lcp_left_.clear();
+    lcp_right_.clear();
+    lcp_rmq_ = RangeMinimum<Index>();
+
+    if (ALPHABET_SIZE == COMPACT_ALPHABET) {
+        size_t alphabet_size = compact_alphabet(workspace);
+        sort_suffixes(workspace.ranks_, alphabet_size, workspace);
+    } else {
+        sort_suffixes(container_, ALPHABET_SIZE, workspace);
+    }
+}
+
+template<typename Container, typename Index>
+template<typename Symbols>
+void SuffixArray<Container, Index>::sort_suffixes(const Symbols& s, size_t alphabet_size,
+                                                  SuffixArrayWorkspace<Index>& workspace) {
+    if (ALGORITHM == SuffixArrayAlgorithm::InducedSorting) {
+        induced_sort(s, alphabet_size, permutation_, workspace);
+        // Colors are expected to be the inverse permutation after building (see BuildLCP)
+        for (size_t i = 0; i < permutation_.size(); ++i) color_[permutation_[i]] = i;
+        return;
+    }
+    size_t k = 1;
+    Index different_colors;
+    if constexpr (HasSymbolBits<Container>::value && std::is_same<Symbols, Container>::value) {
+        different_colors = key_first_step(k, workspace);
+    } else {
+        different_colors = THREADS > 1 ? parallel_first_step(s, alphabet_size, workspace)
+                                       : first_step(s, alphabet_size, workspace);
+    }
+    for (; k < s.size(); k <<= 1) {
+        if (different_colors == s.size()) break;
+        different_colors = THREADS > 1 ? parallel_next_step(k, different_colors, workspace)
+                                       : next_step(k, workspace);
     }
 }
 
-template<typename Container>
-uint32_t SuffixArray<Container>::next_step(size_t k) {
+template<typename Container, typename Index>
+Index SuffixArray<Container, Index>::key_first_step(size_t& k, SuffixArrayWorkspace<Index>& workspace) {
+    // Symbols up to 2^SYMBOL_BITS take LANE_BITS = SYMBOL_BITS + 1 bits. Symbols after the sentinel are zeros
+    // instead of the beginning of the string, it does not change the order since the sentinel is unique.
+    const size_t LANE_BITS = Container::SYMBOL_BITS + 1;
+    size_t size = container_.size();
+    const size_t DIGIT_BITS = size < (size_t(1) << 16) ? 8 : 16; // histogram should not outweigh short strings
+    const size_t DIGIT_MASK = (size_t(1) << DIGIT_BITS) - 1;
+    k = 64 / LANE_BITS;
+
+    auto& keys = workspace.keys_;
+    keys.resize(size);
+    uint64_t key = 0;
+    for (size_t i = size; i > 0; --i) {
+        key = (key >> LANE_BITS) | (uint64_t(container_[i - 1]) << (LANE_BITS * (k - 1)));
+        keys[i - 1] = key;
+    }
+
+    for (size_t i = 0; i < size; ++i) permutation_[i] = i;
+    auto& count = workspace.count_;
+    auto& buffer = workspace.permutation_;
+    buffer.resize(size);
+    for (size_t shift = 0; shift < LANE_BITS * k; shift += DIGIT_BITS) {
+        count.assign(DIGIT_MASK + 1, 0);
+        for (size_t i = 0; i < size; ++i) count[(keys[i] >> shift) & DIGIT_MASK]++;
+        if (count[(keys[0] >> shift) & DIGIT_MASK] == size) continue; // all digits are equal
+        Index offset = 0;
+        for (auto& digit : count) {
+            Index current = digit;
+            digit = offset;
+            offset += current;
+        }
+        for (size_t i = 0; i < size; ++i) {
+            buffer[count[(keys[permutation_[i]] >> shift) & DIGIT_MASK]++] = permutation_[i];
+        }
+        permutation_.swap(buffer);
+    }
+
+    for (size_t i = 1; i < size; ++i) {
+        color_[permutation_[i]] = color_[permutation_[i - 1]] + (keys[permutation_[i]] != keys[permutation_[i - 1]]);
+    }
+    return color_[permutation_.back()] + 1;
+}
+
+template<typename Container, typename Index>
+size_t SuffixArray<Container, Index>::compact_alphabet(SuffixArrayWorkspace<Index>& workspace) {
+    size_t size = container_.size();
+    auto less = [this](Index lhs, Index rhs) {
+        return UnsignedSymbol(container_[lhs]) < UnsignedSymbol(container_[rhs]);
+    };
+    auto equal = [this](Index lhs, Index rhs) { return container_[lhs] == container_[rhs]; };
+    auto& distinct = workspace.count_; // distinct[chunk] - number of distinct symbols in the chunk
+    distinct.assign(THREADS, 0);
+    parallel_for(size, [&](size_t chunk, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) permutation_[i] = i;
+        std::sort(permutation_.begin() + begin, permutation_.begin() + end, less);
+        distinct[chunk] = std::unique(permutation_.begin() + begin, permutation_.begin() + end, equal) -
+                          (permutation_.begin() + begin);
+    });
+    const Index* symbols = permutation_.data();
+    size_t count = distinct[0];
+    std::vector<Index>* merged = &workspace.permutation_;
+    std::vector<Index>* spare = &workspace.color_;
+    for (size_t chunk = 1; chunk < THREADS; ++chunk) {
+        merged->resize(size);
+        auto begin = permutation_.begin() + size * chunk / THREADS;
+        count = std::set_union(symbols, symbols + count, begin, begin + distinct[chunk], merged->begin(), less) -
+                merged->begin();
+        symbols = merged->data();
+        std::swap(merged, spare);
+    }
+
+    auto& ranks = workspace.ranks_;
+    ranks.resize(size);
+    parallel_for(size, [&](size_t, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) ranks[i] = std::lower_bound(symbols, symbols + count, i, less) - symbols;
+    });
+    return count;
+}
+
+template<typename Container, typename Index>
+Index SuffixArray<Container, Index>::next_step(size_t k, SuffixArrayWorkspace<Index>& workspace) {
     for (auto & i : permutation_) i = (i - k + permutation_.size()) % permutation_.size();
 
-    std::vector<int32_t> count(container_.size());
-    std::vector<uint32_t> new_permutation(container_.size());
+    auto& count = workspace.count_;
+    auto& new_permutation = workspace.permutation_;
+    count.assign(container_.size(), 0);
+    new_permutation.resize(container_.size());
     for (const auto & item : permutation_) count[color_[item]]++;
 
     ssize_t size = container_.size();
@@ -75,9 +767,10 @@ uint32_t SuffixArray<Container>::next_step(size_t k) {
     for (ssize_t i = size - 1; i >= 0; --i) {
         new_permutation[--count[color_[permutation_[i]]]] = permutation_[i];
     }
-    permutation_ = std::move(new_permutation);
+    permutation_.swap(new_permutation);
 
-    std::vector<uint32_t> new_color(size);
+    auto& new_color = workspace.color_;
+    new_color.assign(size, 0);
     for (size_t i = 1; i < size; ++i) {
         new_color[permutation_[i]] = new_color[permutation_[i - 1]];
         if (color_[permutation_[i]] != color_[permutation_[i - 1]] ||
@@ -85,18 +778,418 @@ uint32_t SuffixArray<Container>::next_step(size_t k) {
                 new_color[permutation_[i]]++;
         }
     }
-    color_ = std::move(new_color);
+    color_.swap(new_color);
     return color_[permutation_.back()] + 1;
 }
 
-template<typename Container>
-void SuffixArray<Container>::BuildLCP() {
+template<typename Container, typename Index>
+template<typename Function>
+void SuffixArray<Container, Index>::parallel_for(size_t size, Function function) const {
+    std::vector<std::thread> workers;
+    workers.reserve(THREADS - 1);
+    for (size_t chunk = 1; chunk < THREADS; ++chunk) {
+        workers.emplace_back(function, chunk, size * chunk / THREADS, size * (chunk + 1) / THREADS);
+    }
+    function(0, 0, size / THREADS);
+    for (auto& worker : workers) worker.join();
+}
+
+template<typename Container, typename Index>
+template<typename Differs>
+Index SuffixArray<Container, Index>::parallel_recolor(Differs differs, std::vector<Index>& new_color) const {
+    // boundaries[chunk] is the number of class boundaries before the chunk's first element
+    std::vector<Index> boundaries(THREADS);
+    parallel_for(permutation_.size(), [&](size_t chunk, size_t begin, size_t end) {
+        Index count = 0;
+        for (size_t i = std::max<size_t>(begin, 1); i < end; ++i) {
+            count += differs(permutation_[i - 1], permutation_[i]);
+        }
+        boundaries[chunk] = count;
+    });
+    Index total = 0;
+    for (auto& count : boundaries) {
+        Index current = count;
+        count = total;
+        total += current;
+    }
+
+    parallel_for(permutation_.size(), [&](size_t chunk, size_t begin, size_t end) {
+        Index color = boundaries[chunk];
+        for (size_t i = begin; i < end; ++i) {
+            if (i > 0 && differs(permutation_[i - 1], permutation_[i])) color++;
+            new_color[permutation_[i]] = color;
+        }
+    });
+    return total + 1;
+}
+
+template<typename Container, typename Index>
+template<typename Symbols>
+Index SuffixArray<Container, Index>::parallel_first_step(const Symbols& s, size_t alphabet_size,
+                                                         SuffixArrayWorkspace<Index>& workspace) {
+    parallel_for(s.size(), [&](size_t, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) permutation_[i] = i;
+    });
+    parallel_radix_sort([&s](Index position) { return size_t(UnsignedSymbol(s[position])); }, alphabet_size,
+                        workspace);
+
+    return parallel_recolor([&s](Index lhs, Index rhs) {
+        return s[lhs] != s[rhs];
+    }, color_);
+}
+
+template<typename Container, typename Index>
+template<typename Key>
+void SuffixArray<Container, Index>::parallel_radix_sort(Key key, size_t keys, SuffixArrayWorkspace<Index>& workspace) {
+    const size_t DIGIT_BITS = 16;
+    const size_t DIGIT_MASK = (size_t(1) << DIGIT_BITS) - 1;
+    size_t size = permutation_.size();
+    auto& buffer = workspace.permutation_;
+    buffer.resize(size);
+    std::vector<std::vector<Index>> count(THREADS, std::vector<Index>(std::min(keys, DIGIT_MASK + 1)));
+    for (size_t shift = 0; shift == 0 || (shift < std::numeric_limits<size_t>::digits && ((keys - 1) >> shift) > 0);
+         shift += DIGIT_BITS) {
+        parallel_for(size, [&](size_t chunk, size_t begin, size_t end) {
+            std::fill(count[chunk].begin(), count[chunk].end(), 0);
+            for (size_t i = begin; i < end; ++i) count[chunk][(key(permutation_[i]) >> shift) & DIGIT_MASK]++;
+        });
+        Index offset = 0;
+        for (size_t digit = 0; digit < count[0].size(); ++digit) {
+            for (size_t chunk = 0; chunk < THREADS; ++chunk) {
+                Index current = count[chunk][digit];
+                count[chunk][digit] = offset;
+                offset += current;
+            }
+        }
+        parallel_for(size, [&](size_t chunk, size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                buffer[count[chunk][(key(permutation_[i]) >> shift) & DIGIT_MASK]++] = permutation_[i];
+            }
+        });
+        permutation_.swap(buffer);
+    }
+}
+
+template<typename Container, typename Index>
+Index SuffixArray<Container, Index>::parallel_next_step(size_t k, Index colors,
+                                                      SuffixArrayWorkspace<Index>& workspace) {
+    size_t size = permutation_.size();
+    parallel_for(size, [&](size_t, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            permutation_[i] = permutation_[i] >= k ? permutation_[i] - k : permutation_[i] + size - k;
+        }
+    });
+
+    // Stable sort by the color of the first half, digit by digit starting from the lowest one
+    parallel_radix_sort([this](Index position) { return static_cast<size_t>(color_[position]); }, colors, workspace);
+
+    auto& buffer = workspace.permutation_;
+    Index different_colors = parallel_recolor([this, k, size](Index lhs, Index rhs) {
+        return color_[lhs] != color_[rhs] ||
+               color_[lhs + k < size ? lhs + k : lhs + k - size] != color_[rhs + k < size ? rhs + k : rhs + k - size];
+    }, buffer);
+    color_.swap(buffer);
+    return different_colors;
+}
+
+template<typename Container, typename Index>
+template<typename Symbols>
+void SuffixArray<Container, Index>::induced_sort(const Symbols& s, size_t alphabet_size, std::vector<Index>& sa,
+                                                 SuffixArrayWorkspace<Index>& workspace, size_t depth) {
+    const Index EMPTY = std::numeric_limits<Index>::max();
+    size_t size = s.size();
+    sa.assign(size, EMPTY);
+    if (size == 1) {
+        sa[0] = 0;
+        return;
+    }
+    if (workspace.levels_.size() == depth) workspace.levels_.emplace_back();
+    auto symbol = [&s](size_t i) { return UnsignedSymbol(s[i]); };
+    auto& level = workspace.levels_[depth];
+
+    // is_s[i] is true if suffix i is less than suffix i + 1 (S-type), otherwise it is L-type.
+    // Sentinel is S-type by definition.
+    auto& is_s = level.is_s;
+    is_s.assign(size, false);
+    is_s[size - 1] = true;
+    for (ssize_t i = size - 2; i >= 0; --i) {
+        is_s[i] = symbol(i) < symbol(i + 1) || (symbol(i) == symbol(i + 1) && is_s[i + 1]);
+    }
+    auto is_lms = [&is_s](size_t i) { return i > 0 && is_s[i] && !is_s[i - 1]; };
+
+    auto& bucket_begin = level.bucket_begin;
+    bucket_begin.assign(alphabet_size + 1, 0);
+    for (size_t i = 0; i < size; ++i) bucket_begin[symbol(i) + 1]++;
+    for (size_t i = 1; i <= alphabet_size; ++i) bucket_begin[i] += bucket_begin[i - 1];
+    auto& bucket = level.bucket;
+    bucket.resize(alphabet_size);
+
+    auto induce = [&]() {
+        std::copy(bucket_begin.begin(), bucket_begin.end() - 1, bucket.begin());
+        for (size_t i = 0; i < size; ++i) {
+            if (sa[i] != EMPTY && sa[i] > 0 && !is_s[sa[i] - 1]) sa[bucket[symbol(sa[i] - 1)]++] = sa[i] - 1;
+        }
+        std::copy(bucket_begin.begin() + 1, bucket_begin.end(), bucket.begin());
+        for (ssize_t i = size - 1; i >= 0; --i) {
+            if (sa[i] != EMPTY && sa[i] > 0 && is_s[sa[i] - 1]) sa[--bucket[symbol(sa[i] - 1)]] = sa[i] - 1;
+        }
+    };
+
+    // Sorting LMS substrings: put LMS positions to the ends of their buckets and induce.
+    std::copy(bucket_begin.begin() + 1, bucket_begin.end(), bucket.begin());
+    auto& lms = level.lms;
+    lms.clear();
+    for (size_t i = 1; i < size; ++i) {
+        if (is_lms(i)) {
+            sa[--bucket[symbol(i)]] = i;
+            lms.push_back(i);
+        }
+    }
+    induce();
+
+    // Naming sorted LMS substrings. Equal substrings get equal names. LMS positions are at least
+    // two apart, so the name of LMS position i is stored at i / 2.
+    auto& name = level.name;
+    name.assign((size + 1) / 2, EMPTY);
+    Index names = 0;
+    size_t prev = EMPTY;
+    for (size_t i = 0; i < size; ++i) {
+        size_t cur = sa[i];
+        if (!is_lms(cur)) continue;
+        bool equal = prev != EMPTY;
+        for (size_t d = 0; equal; ++d) {
+            if (s[cur + d] != s[prev + d] || is_s[cur + d] != is_s[prev + d]) {
+                equal = false;
+            } else if (d > 0 && (is_lms(cur + d) || is_lms(prev + d))) {
+                equal = is_lms(cur + d) && is_lms(prev + d);
+                break;
+            }
+        }
+        if (!equal) names++;
+        name[cur / 2] = names - 1;
+        prev = cur;
+    }
+
+    // Sorting LMS suffixes. The last LMS suffix is the sentinel, so reduced string ends with a sentinel too.
+    auto& reduced = level.reduced;
+    reduced.resize(lms.size());
+    for (size_t i = 0; i < lms.size(); ++i) reduced[i] = name[lms[i] / 2];
+    auto& reduced_sa = level.reduced_sa;
+    reduced_sa.resize(lms.size());
+    if (names < lms.size()) {
+        induced_sort(reduced, names, reduced_sa, workspace, depth + 1);
+    } else {
+        for (size_t i = 0; i < lms.size(); ++i) reduced_sa[reduced[i]] = i;
+    }
+
+    // Inducing the order of all suffixes from sorted LMS suffixes.
+    sa.assign(size, EMPTY);
+    std::copy(bucket_begin.begin() + 1, bucket_begin.end(), bucket.begin());
+    for (ssize_t i = lms.size() - 1; i >= 0; --i) {
+        size_t pos = lms[reduced_sa[i]];
+        sa[--bucket[symbol(pos)]] = pos;
+    }
+    induce();
+}
+
+template<typename Container, typename Index>
+size_t SuffixArray<Container, Index>::common_prefix(size_t i, size_t j, size_t skip) const {
+    // Suffixes are different and the sentinel is unique, so comparison stops before the end
+    if constexpr (HasCommonPrefix<Container>::value) {
+        return skip + container_.CommonPrefix(i + skip, container_, j + skip, container_.size());
+    } else {
+        while (container_[i + skip] == container_[j + skip]) skip++;
+        return skip;
+    }
+}
+
+template<typename Container, typename Index>
+void SuffixArray<Container, Index>::restore_inverse() {
+    if (color_.size() == container_.size()) return;
+    color_.resize(container_.size());
+    for (size_t i = 0; i < container_.size(); ++i) color_[array_at(i)] = i;
+}
+
+template<typename Container, typename Index>
+void SuffixArray<Container, Index>::BuildLCP(LCPAlgorithm algorithm, LCPStorage storage) {
+    compressed_lcp_ = CompressedLCP<Index>();
+    packed_lcp_ = PackedArray();
+    if (algorithm == LCPAlgorithm::Phi) {
+        build_lcp_phi();
+        if (storage == LCPStorage::Compressed) {
+            compressed_lcp_ = CompressedLCP<Index>::Compress(lcp_);
+            lcp_ = std::vector<Index>();
+        } else if (storage == LCPStorage::Packed) {
+            packed_lcp_ = PackedArray::Pack(lcp_, packed_width());
+            lcp_ = std::vector<Index>();
+        }
+    } else if (storage == LCPStorage::Compressed) {
+        lcp_ = std::vector<Index>();
+        CompressedLCP<Index> result(container_.size());
+        build_lcp_kasai([&result](size_t i, Index value) { result.Set(i, value); });
+        result.Finish();
+        compressed_lcp_ = std::move(result);
+    } else if (storage == LCPStorage::Packed) {
+        lcp_ = std::vector<Index>();
+        PackedArray result(container_.size(), packed_width());
+        build_lcp_kasai([&result](size_t i, Index value) { result.Set(i, value); });
+        packed_lcp_ = std::move(result);
+    } else {
+        lcp_.assign(container_.size(), 0);
+        build_lcp_kasai([this](size_t i, Index value) { lcp_[i] = value; });
+    }
+    // RMQ is rebuilt over the new storage, it also restores the inverse array which Phi mode releases
+    if (!lcp_rmq_.Empty()) BuildLCPRMQ();
+}
+
+template<typename Container, typename Index>
+std::vector<Index> SuffixArray<Container, Index>::GetLCP() const {
+    if (compressed_lcp_.empty() && packed_lcp_.empty()) return lcp_;
+    std::vector<Index> result(container_.size());
+    if (!compressed_lcp_.empty()) {
+        compressed_lcp_.Decode(0, result.size(), result.data());
+    } else {
+        packed_lcp_.Decode(0, result.size(), result.data());
+    }
+    return result;
+}
+
+template<typename Container, typename Index>
+std::vector<Index> SuffixArray<Container, Index>::GetArray() const {
+    if (packed_array_.empty()) return permutation_;
+    std::vector<Index> result(packed_array_.size());
+    packed_array_.Decode(0, result.size(), result.data());
+    return result;
+}
+
+template<typename Container, typename Index>
+void SuffixArray<Container, Index>::Pack() {
+    if (packed_array_.empty()) {
+        packed_array_ = PackedArray::Pack(permutation_, packed_width());
+        permutation_ = std::vector<Index>();
+    }
+    if (!lcp_.empty()) {
+        packed_lcp_ = PackedArray::Pack(lcp_, packed_width());
+        lcp_ = std::vector<Index>();
+    }
+    // RMQ keeps positions of minima, not values, so it stays valid over the packed LCP
+    if (lcp_rmq_.Empty()) color_ = std::vector<Index>();
+}
+
+template<typename Container, typename Index>
+template<typename Store>
+void SuffixArray<Container, Index>::build_lcp_kasai(Store store) {
+    restore_inverse();
     const auto& inverse = color_;
-    int32_t cur_lcp = 0;
-    for (size_t i = 0; i < permutation_.size() - 1; ++i) {
-        cur_lcp = std::max(cur_lcp - 1, 0);
-        size_t prev = permutation_[inverse[i] - 1]; // suffix that goes before current one in suff array
-        while (container_[i + cur_lcp] == container_[prev + cur_lcp]) cur_lcp++;
-        lcp_[inverse[i]] = cur_lcp;
-    }
-}
\ No newline at end of file
+    size_t cur_lcp = 0;
+    for (size_t i = 0; i < container_.size() - 1; ++i) {
+        if (cur_lcp > 0) cur_lcp--;
+        size_t prev = array_at(inverse[i] - 1); // suffix that goes before current one in suff array
+        cur_lcp = common_prefix(i, prev, cur_lcp);
+        store(inverse[i], cur_lcp);
+    }
+}
+
+template<typename Container, typename Index>
+void SuffixArray<Container, Index>::build_lcp_phi() {
+    size_t size = container_.size();
+    size_t sentinel = array_at(0); // the only suffix without the previous one
+    auto& plcp = color_;
+    plcp.resize(size);
+    parallel_for(size, [&](size_t, size_t begin, size_t end) {
+        for (size_t i = std::max<size_t>(begin, 1); i < end; ++i) plcp[array_at(i)] = array_at(i - 1);
+    });
+
+    // PLCP[i + 1] >= PLCP[i] - 1, so every chunk of text positions goes left to right like Kasai's algorithm,
+    // only its first position is compared from the beginning. Phi[i] is replaced by PLCP[i].
+    parallel_for(size, [&](size_t, size_t begin, size_t end) {
+        size_t cur_lcp = 0;
+        for (size_t i = begin; i < end; ++i) {
+            if (i == sentinel) {
+                plcp[i] = cur_lcp = 0;
+                continue;
+            }
+            cur_lcp = common_prefix(i, plcp[i], cur_lcp);
+            plcp[i] = cur_lcp;
+            if (cur_lcp > 0) cur_lcp--;
+        }
+    });
+
+    // LCP[j] = PLCP[SA[j]]: the permutation is applied in place following its cycles
+    BitVector done(size);
+    for (size_t start = 0; start < size; ++start) {
+        if (done[start]) continue;
+        Index first = plcp[start];
+        size_t cur = start;
+        for (size_t next = array_at(cur); next != start; cur = next, next = array_at(cur)) {
+            plcp[cur] = plcp[next];
+            done.Set(cur);
+        }
+        plcp[cur] = first;
+        done.Set(cur);
+    }
+    // LCP takes the buffer, and previous LCP buffer is kept for the inverse array to reuse memory on rebuilds
+    lcp_.swap(plcp);
+    color_.clear();
+}
+
+template<typename Container, typename Index>
+Index SuffixArray<Container, Index>::build_lcp_lr(size_t left, size_t right) {
+    if (right - left == 1) return right < container_.size() ? lcp_at(right) : 0;
+    size_t middle = (left + right) / 2;
+    lcp_left_[middle] = build_lcp_lr(left, middle);
+    lcp_right_[middle] = build_lcp_lr(middle, right);
+    return std::min(lcp_left_[middle], lcp_right_[middle]);
+}
+
+template<typename Container, typename Index>
+void SuffixArray<Container, Index>::BuildLCPLR() {
+    lcp_left_.assign(container_.size(), 0);
+    lcp_right_.assign(container_.size(), 0);
+    build_lcp_lr(0, container_.size());
+}
+
+template<typename Container, typename Index>
+template<typename Pattern>
+std::pair<size_t, size_t> SuffixArray<Container, Index>::Range(const Pattern& pattern) const {
+    if (!packed_array_.empty()) return search(packed_array_.GetView()).Range(pattern);
+    return search(GetArrayView()).Range(pattern);
+}
+
+template<typename Container, typename Index>
+template<typename Pattern>
+size_t SuffixArray<Container, Index>::Count(const Pattern& pattern) const {
+    auto range = Range(pattern);
+    return range.second - range.first;
+}
+
+template<typename Container, typename Index>
+template<typename Pattern>
+std::vector<Index> SuffixArray<Container, Index>::Locate(const Pattern& pattern) const {
+    auto range = Range(pattern);
+    if (packed_array_.empty()) {
+        return std::vector<Index>(permutation_.begin() + range.first, permutation_.begin() + range.second);
+    }
+    std::vector<Index> result(range.second - range.first);
+    packed_array_.Decode(range.first, range.second, result.data());
+    return result;
+}
+
+template<typename Container, typename Index>
+template<typename Pattern>
+std::vector<std::pair<size_t, size_t>> SuffixArray<Container, Index>::RangeBatch(const std::vector<Pattern>& patterns) const {
+    if (!packed_array_.empty()) return search(packed_array_.GetView()).RangeBatch(patterns);
+    return search(GetArrayView()).RangeBatch(patterns);
+}
+
+template<typename Container, typename Index>
+Index SuffixArray<Container, Index>::Lcp(size_t i, size_t j) const {
+    if (i == j) return container_.size() - 1 - i; // the sentinel is not counted as in LCP values
+    // color_ is the inverse permutation after building
+    size_t left = std::min(color_[i], color_[j]), right = std::max(color_[i], color_[j]);
+    if (!compressed_lcp_.empty()) return compressed_lcp_[lcp_rmq_.Query(compressed_lcp_, left + 1, right)];
+    if (!packed_lcp_.empty()) return packed_lcp_[lcp_rmq_.Query(packed_lcp_, left + 1, right)];
+    return lcp_[lcp_rmq_.Query(lcp_, left + 1, right)];
+}
+
+#endif //AADS_SUFFARRAY_LCP_CPP
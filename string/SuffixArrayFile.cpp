@@ -0,0 +1,267 @@
+#ifndef AADS_SUFFIX_ARRAY_FILE_CPP
+#define AADS_SUFFIX_ARRAY_FILE_CPP
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "SuffArray + LCP.cpp"
+
+// Index file layout (all integers are in the byte order of the host which wrote the file,
+// files written with the other byte order are rejected by BYTE_ORDER_MARK):
+//   header | text | suffix array | LCP
+// Every section starts at an offset aligned to SECTION_ALIGNMENT, so mapped arrays can be used in place.
+namespace SuffixArrayFile {
+    const char MAGIC[8] = {'A', 'A', 'D', 'S', 'S', 'A', 'I', 'X'};
+    const uint32_t VERSION = 2;
+    const uint32_t BYTE_ORDER_MARK = 0x01020304;
+    const uint64_t SECTION_ALIGNMENT = 64;
+
+    struct Header {
+        char     magic[8];
+        uint32_t version;
+        uint32_t symbol_size; // sizeof of the text symbol
+        uint32_t index_size;  // sizeof of suffix array and LCP elements
+        uint32_t byte_order;  // BYTE_ORDER_MARK as written by the host
+        uint64_t length;      // number of symbols including the sentinel
+        uint64_t text_offset;
+        uint64_t array_offset;
+        uint64_t lcp_offset;
+    };
+
+    inline uint64_t Align(uint64_t offset) {
+        return (offset + SECTION_ALIGNMENT - 1) / SECTION_ALIGNMENT * SECTION_ALIGNMENT;
+    }
+
+    inline void Pad(std::ofstream& out, uint64_t& offset) {
+        static const char zeros[SECTION_ALIGNMENT] = {};
+        uint64_t aligned = Align(offset);
+        out.write(zeros, aligned - offset);
+        offset = aligned;
+    }
+}
+
+/// \brief: Writes text, suffix array and LCP to a file which can be opened by MappedSuffixArray.
+/// BuildLCP should be called before saving, std::logic_error is thrown otherwise.
+template <typename Container, typename Index>
+void SaveSuffixArray(const SuffixArray<Container, Index>& suffix_array, const std::string& path) {
+    using Symbol = typename std::decay<decltype(suffix_array.container_[0])>::type;
+    static_assert(std::is_trivially_copyable<Symbol>::value, "Text symbols should be trivially copyable.\n");
+    const auto& compressed_lcp = suffix_array.compressed_lcp_;
+    const auto& packed_lcp = suffix_array.packed_lcp_;
+    uint64_t length = suffix_array.container_.size();
+    if (suffix_array.lcp_.size() != length && compressed_lcp.size() != length && packed_lcp.size() != length) {
+        throw std::logic_error("SaveSuffixArray: LCP is not built");
+    }
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) throw std::system_error(errno, std::generic_category(), "Can't open " + path);
+
+    SuffixArrayFile::Header header{};
+    std::memcpy(header.magic, SuffixArrayFile::MAGIC, sizeof(header.magic));
+    header.version = SuffixArrayFile::VERSION;
+    header.byte_order = SuffixArrayFile::BYTE_ORDER_MARK;
+    header.symbol_size = sizeof(Symbol);
+    header.index_size = sizeof(Index);
+    header.length = length;
+    header.text_offset = SuffixArrayFile::Align(sizeof(header));
+    header.array_offset = SuffixArrayFile::Align(header.text_offset + length * sizeof(Symbol));
+    header.lcp_offset = SuffixArrayFile::Align(header.array_offset + length * sizeof(Index));
+
+    uint64_t offset = sizeof(header);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    SuffixArrayFile::Pad(out, offset);
+
+    // Container is not required to be contiguous, so the text is written through a buffer
+    std::vector<Symbol> buffer;
+    buffer.reserve(1 << 16);
+    for (const auto& symbol : suffix_array.container_) {
+        buffer.push_back(symbol);
+        if (buffer.size() == buffer.capacity()) {
+            out.write(reinterpret_cast<const char*>(buffer.data()), buffer.size() * sizeof(Symbol));
+            buffer.clear();
+        }
+    }
+    out.write(reinterpret_cast<const char*>(buffer.data()), buffer.size() * sizeof(Symbol));
+    offset += length * sizeof(Symbol);
+    SuffixArrayFile::Pad(out, offset);
+
+    // The file keeps plain arrays, compressed and packed ones are decoded by chunks
+    std::vector<Index> chunk(std::min<size_t>(length, 1 << 16));
+    auto write_decoded = [&out, &chunk, length](const auto& values) {
+        for (size_t begin = 0; begin < length; begin += chunk.size()) {
+            size_t end = std::min<size_t>(length, begin + chunk.size());
+            values.Decode(begin, end, chunk.data());
+            out.write(reinterpret_cast<const char*>(chunk.data()), (end - begin) * sizeof(Index));
+        }
+    };
+    if (suffix_array.packed_array_.empty()) {
+        out.write(reinterpret_cast<const char*>(suffix_array.permutation_.data()), length * sizeof(Index));
+    } else {
+        write_decoded(suffix_array.packed_array_);
+    }
+    offset += length * sizeof(Index);
+    SuffixArrayFile::Pad(out, offset);
+    if (!compressed_lcp.empty()) {
+        write_decoded(compressed_lcp);
+    } else if (!packed_lcp.empty()) {
+        write_decoded(packed_lcp);
+    } else {
+        out.write(reinterpret_cast<const char*>(suffix_array.lcp_.data()), length * sizeof(Index));
+    }
+
+    out.flush();
+    if (!out) throw std::system_error(errno, std::generic_category(), "Can't write " + path);
+}
+
+/// \brief: Read-only suffix array index mapped from a file written by SaveSuffixArray.
+/// Nothing is copied or rebuilt on open, pages are loaded by the OS on first access.
+/// Patterns are searched in the mapped arrays in O(m log n), like in SuffixArray without LCP-LR.
+template <typename Symbol = char, typename Index = uint32_t>
+class MappedSuffixArray {
+public:
+    explicit MappedSuffixArray(const std::string& path);
+    MappedSuffixArray(MappedSuffixArray&& other) noexcept;
+    MappedSuffixArray& operator=(MappedSuffixArray&& other) noexcept;
+    MappedSuffixArray(const MappedSuffixArray&) = delete;
+    MappedSuffixArray& operator=(const MappedSuffixArray&) = delete;
+    ~MappedSuffixArray();
+
+    [[nodiscard]] ArrayView<Symbol> GetText() const { return text_; }
+    [[nodiscard]] ArrayView<Index> GetArray() const { return array_; }
+    [[nodiscard]] ArrayView<Index> GetLCP() const { return lcp_; }
+
+    // Occurrences of the pattern (without sentinel) form a range of the suffix array
+    template <typename Pattern>
+    [[nodiscard]] std::pair<size_t, size_t> Range(const Pattern& pattern) const { return search().Range(pattern); }
+    template <typename Pattern>
+    [[nodiscard]] size_t Count(const Pattern& pattern) const;
+    // Positions of occurrences in suffix array order
+    template <typename Pattern>
+    [[nodiscard]] std::vector<Index> Locate(const Pattern& pattern) const;
+    template <typename Pattern>
+    [[nodiscard]] std::vector<std::pair<size_t, size_t>> RangeBatch(const std::vector<Pattern>& patterns) const {
+        return search().RangeBatch(patterns);
+    }
+
+private:
+    SuffixArraySearch<ArrayView<Symbol>, Index> search() const {
+        return SuffixArraySearch<ArrayView<Symbol>, Index>(text_, array_);
+    }
+    template <typename T>
+    ArrayView<T> section(uint64_t offset, uint64_t length) const;
+
+    void*  data_;
+    size_t size_;
+    ArrayView<Symbol> text_;
+    ArrayView<Index>  array_;
+    ArrayView<Index>  lcp_;
+};
+
+template <typename Symbol, typename Index>
+MappedSuffixArray<Symbol, Index>::MappedSuffixArray(const std::string& path) : data_(MAP_FAILED), size_(0) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd == -1) throw std::system_error(errno, std::generic_category(), "Can't open " + path);
+
+    struct stat info{};
+    if (fstat(fd, &info) == -1) {
+        int error = errno;
+        close(fd);
+        throw std::system_error(error, std::generic_category(), "Can't stat " + path);
+    }
+    size_ = info.st_size;
+    if (size_ < sizeof(SuffixArrayFile::Header)) {
+        close(fd);
+        throw std::runtime_error(path + " is not a suffix array index");
+    }
+    data_ = mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+    int error = errno;
+    close(fd);
+    if (data_ == MAP_FAILED) throw std::system_error(error, std::generic_category(), "Can't map " + path);
+
+    const auto& header = *static_cast<const SuffixArrayFile::Header*>(data_);
+    try {
+        if (std::memcmp(header.magic, SuffixArrayFile::MAGIC, sizeof(header.magic)) != 0) {
+            throw std::runtime_error(path + " is not a suffix array index");
+        }
+        if (header.version != SuffixArrayFile::VERSION) {
+            throw std::runtime_error(path + " has unsupported version " + std::to_string(header.version));
+        }
+        if (header.byte_order != SuffixArrayFile::BYTE_ORDER_MARK) {
+            throw std::runtime_error(path + " was written with different byte order");
+        }
+        if (header.symbol_size != sizeof(Symbol) || header.index_size != sizeof(Index)) {
+            throw std::runtime_error(path + " was written with different symbol or index type");
+        }
+        text_ = section<Symbol>(header.text_offset, header.length);
+        array_ = section<Index>(header.array_offset, header.length);
+        lcp_ = section<Index>(header.lcp_offset, header.length);
+    } catch (...) {
+        munmap(data_, size_);
+        throw;
+    }
+}
+
+template <typename Symbol, typename Index>
+template <typename T>
+ArrayView<T> MappedSuffixArray<Symbol, Index>::section(uint64_t offset, uint64_t length) const {
+    if (offset % SuffixArrayFile::SECTION_ALIGNMENT != 0 || offset > size_ || (size_ - offset) / sizeof(T) < length) {
+        throw std::runtime_error("Suffix array index is truncated or corrupted");
+    }
+    return ArrayView<T>(reinterpret_cast<const T*>(static_cast<const char*>(data_) + offset), length);
+}
+
+template <typename Symbol, typename Index>
+template <typename Pattern>
+size_t MappedSuffixArray<Symbol, Index>::Count(const Pattern& pattern) const {
+    auto range = Range(pattern);
+    return range.second - range.first;
+}
+
+template <typename Symbol, typename Index>
+template <typename Pattern>
+std::vector<Index> MappedSuffixArray<Symbol, Index>::Locate(const Pattern& pattern) const {
+    auto range = Range(pattern);
+    return std::vector<Index>(array_.begin() + range.first, array_.begin() + range.second);
+}
+
+template <typename Symbol, typename Index>
+MappedSuffixArray<Symbol, Index>::MappedSuffixArray(MappedSuffixArray&& other) noexcept :
+        data_(other.data_), size_(other.size_), text_(other.text_), array_(other.array_), lcp_(other.lcp_) {
+    other.data_ = MAP_FAILED;
+    other.size_ = 0;
+}
+
+template <typename Symbol, typename Index>
+MappedSuffixArray<Symbol, Index>& MappedSuffixArray<Symbol, Index>::operator=(MappedSuffixArray&& other) noexcept {
+    if (this != &other) {
+        if (data_ != MAP_FAILED) munmap(data_, size_);
+        data_ = other.data_;
+        size_ = other.size_;
+        text_ = other.text_;
+        array_ = other.array_;
+        lcp_ = other.lcp_;
+        other.data_ = MAP_FAILED;
+        other.size_ = 0;
+    }
+    return *this;
+}
+
+template <typename Symbol, typename Index>
+MappedSuffixArray<Symbol, Index>::~MappedSuffixArray() {
+    if (data_ != MAP_FAILED) munmap(data_, size_);
+}
+
+#endif //AADS_SUFFIX_ARRAY_FILE_CPP
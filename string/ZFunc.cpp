@@ -1,7 +1,12 @@
+#ifndef AADS_Z_FUNC_CPP
+#define AADS_Z_FUNC_CPP
+
 #include <iostream>
 #include <string>
 #include <vector>
 
+#include "MatchLength.h"
+
 template <typename It, typename T = uint32_t>
 std::vector<T> CalculateZFunc(It begin, It end) {
     static_assert(
@@ -18,9 +23,7 @@ std::vector<T> CalculateZFunc(It begin, It end) {
         if (left < z_block_end) {
             result[ind] = std::min(result[left - z_block_start], T(z_block_end - left));
         }
-        while (left + result[ind] < end && *(left + result[ind]) == *(begin + result[ind])) {
-            result[ind]++;
-        }
+        result[ind] += ExtendMatch(left + result[ind], begin + result[ind], (end - left) - result[ind]);
         if (left + result[ind] > z_block_end) {
             z_block_end = left + result[ind];
             z_block_start = left;
@@ -28,3 +31,40 @@ std::vector<T> CalculateZFunc(It begin, It end) {
     }
     return result;
 }
+
+
+/// \brief: Finds occurrences of pattern [pattern_begin, pattern_end) in text [text_begin, text_end)
+/// without building "pattern#text". Z function is calculated for the pattern only and the text is
+/// scanned keeping the rightmost text block that matches a pattern prefix, so extra memory is O(|pattern|).
+/// callback(position) is called for every occurrence in increasing order of positions.
+template <typename PatternIt, typename TextIt, typename Callback, typename T = uint32_t>
+void SearchWithZFunc(PatternIt pattern_begin, PatternIt pattern_end, TextIt text_begin, TextIt text_end,
+                     Callback callback) {
+    static_assert(
+            std::is_same<std::random_access_iterator_tag,
+            typename std::iterator_traits<TextIt>::iterator_category>::value,
+            "To search with Z function use random access iterators.\n"
+            );
+    size_t pattern_len = std::distance(pattern_begin, pattern_end);
+    size_t text_len = std::distance(text_begin, text_end);
+    if (pattern_len == 0) return;
+    std::vector<T> pattern_z = CalculateZFunc<PatternIt, T>(pattern_begin, pattern_end);
+
+    // text[block_start, block_end) == pattern[0, block_end - block_start)
+    size_t block_start = 0, block_end = 0;
+    for (size_t ind = 0; ind < text_len; ++ind) {
+        size_t len = 0;
+        if (ind < block_end) {
+            len = std::min<size_t>(pattern_z[ind - block_start], block_end - ind);
+        }
+        len += ExtendMatch(text_begin + (ind + len), pattern_begin + len,
+                           std::min(pattern_len - len, text_len - ind - len));
+        if (ind + len > block_end) {
+            block_start = ind;
+            block_end = ind + len;
+        }
+        if (len == pattern_len) callback(ind);
+    }
+}
+
+#endif //AADS_Z_FUNC_CPP